@@ -0,0 +1,24 @@
+// Point lights binned into view space clusters on the CPU (see ClusterBuffers); needs uniforms.glsl
+layout (std140) uniform ClusterBlock
+{
+    vec4 ClusterDepth;      // near plane, depth slices per unit of log(depth / near plane)
+    ivec4 ClusterSize;      // clusters in x, y and z, lights
+    ivec4 ClusterOffsets;   // first texel of this frame's lights, cluster ranges and indices
+};
+
+uniform samplerBuffer ClusterLights;    // two texels per light: view space position and radius, color
+uniform usamplerBuffer ClusterRanges;   // per cluster: first index and number of lights
+uniform usamplerBuffer ClusterIndices;  // into ClusterLights
+
+// Returns the first index and the number of lights of the cluster that contains a view space position;
+// tiles split the screen evenly, slices split the depth exponentially
+uvec2 findCluster(vec3 position)
+{
+    vec4 clip = ProjectionMatrix * vec4(position, 1.0);
+    vec2 tile = (clip.xy / clip.w * 0.5 + 0.5) * vec2(ClusterSize.xy);
+    float slice = log(max(-position.z, ClusterDepth.x) / ClusterDepth.x) * ClusterDepth.y;
+
+    ivec3 cell = clamp(ivec3(ivec2(tile), int(slice)), ivec3(0), ClusterSize.xyz - 1);
+    int cluster = cell.x + ClusterSize.x * (cell.y + ClusterSize.y * cell.z);
+    return texelFetch(ClusterRanges, ClusterOffsets.y + cluster).xy;
+}
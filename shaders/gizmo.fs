@@ -0,0 +1,11 @@
+#version 330
+
+in vec3 color;
+
+layout (location = 0) out vec4 FragColor;
+
+void main()
+{
+    // a light is drawn in its own color, unshaded
+    FragColor = vec4(color, 1.0);
+}
@@ -0,0 +1,21 @@
+#version 330
+
+// Light gizmos: one small sphere per light, all drawn with one instanced call (see LightGizmos)
+
+#include "uniforms.glsl"
+
+// Unit icosphere, shared by all lights
+layout (location = 0) in vec3 Position;
+// Position in world space and size of the gizmo, color of its light; advanced per instance
+layout (location = 4) in vec4 GizmoPosition;
+layout (location = 5) in vec4 GizmoColor;
+
+out vec3 color;
+
+void main()
+{
+    color = GizmoColor.rgb;
+
+    vec3 position = Position * GizmoPosition.w + GizmoPosition.xyz;
+    gl_Position = ProjectionMatrix * ViewMatrix * vec4(position, 1.0);
+}
@@ -1,29 +1,32 @@
 #version 330
 
-uniform float DiffuseFactor;
-uniform float SpecularFactor;
-uniform float AmbientFactor;
-uniform mat4 ViewMatrix;
+#include "uniforms.glsl"
 
+#ifdef CLUSTERED_LIGHTS
+#include "clusters.glsl"
+#endif
+
+#ifdef TEXTURED
 uniform sampler2D tex;
+#endif
 
 in vec3 color;
 in vec3 normalInt;
 in vec3 vertPosInt;
+#ifdef TEXTURED
 in vec2 UVcoords; // coordinates of fragment
+#endif
 
 struct Light {
-    vec3 position;
+    vec3 position; // in view space
     vec3 color;
 };
-uniform Light light;
 
 layout (location = 0) out vec4 FragColor;
 
 vec3 calculatePhong(vec3 normal, vec3 vertPos, Light light) {
     // vertex to light source vector (L)
-    vec3 lightPos = (ViewMatrix * vec4(light.position, 1.)).xyz;
-    vec3 lightDir = normalize(lightPos - vertPos);
+    vec3 lightDir = normalize(light.position - vertPos);
 
     vec3 viewer = normalize(-vertPos.xyz);
 
@@ -58,15 +61,36 @@ vec3 calculatePhong(vec3 normal, vec3 vertPos, Light light) {
 
 void main()
 {
+#ifdef TEXTURED
     // Read color at UVcoords position in the texture
-    vec4 TexColor = texture2D(tex, UVcoords);
+    vec4 TexColor = texture(tex, UVcoords);
+#else
+    // White, like the placeholder of a texture that is not resident yet
+    vec4 TexColor = vec4(1.0);
+#endif
 
     // normalize vector again, in case its not unit anymore
     // because of interpolation
     vec3 normal = normalize(normalInt);
 
+    Light light = Light((ViewMatrix * vec4(LightPosition.xyz, 1.)).xyz, LightColor.xyz);
     vec3 lightFactor = calculatePhong(normal, vertPosInt, light);
 
+#ifdef CLUSTERED_LIGHTS
+    // Point lights: only those of the fragment's cluster, fading out towards their radius
+    uvec2 range = findCluster(vertPosInt);
+    for (uint i = range.x; i < range.x + range.y; i++)
+    {
+        int index = ClusterOffsets.x + 2 * int(texelFetch(ClusterIndices, ClusterOffsets.z + int(i)).x);
+        vec4 positionRadius = texelFetch(ClusterLights, index);
+        vec3 pointColor = texelFetch(ClusterLights, index + 1).rgb;
+
+        float reach = length(positionRadius.xyz - vertPosInt) / positionRadius.w;
+        float falloff = clamp(1.0 - reach * reach, 0.0, 1.0);
+        lightFactor += calculatePhong(normal, vertPosInt, Light(positionRadius.xyz, pointColor)) * falloff * falloff;
+    }
+#endif
+
     // Ambient Reflection: I_A = k_A * I_L
     // k_A: AmbientFactor
     // I_L: Light at Surface Location
@@ -4,44 +4,70 @@
 // in gouraud light calculations are done per vertex
 // in phong they are done per fragment
 
-// Uniform input
-uniform mat4 ProjectionMatrix;
-uniform mat4 ViewMatrix;
-uniform mat4 TransformMatrix;
+// Variants are specialized with #defines (see ShaderVariants):
+// TEXTURED - the fragment shader samples the part's texture
+// CLUSTERED_LIGHTS - the fragment shader adds the point lights of its cluster
+
+#include "uniforms.glsl"
+
 
 // Content of the vertex data (attributes)
 layout (location = 0) in vec3 Position;
 layout (location = 1) in vec3 Color;
-layout (location = 2) in vec3 Normal;
+layout (location = 2) in vec2 Normal; // octahedral encoded
 layout (location = 3) in vec2 UV;
+// Model-view and normal matrix of the instance, computed once per instance on the CPU (see RenderQueue);
+// rows 0 to 2 of the row-major model-view matrix and the rows of its inverse transpose 3x3 part
+layout (location = 4) in vec4 ModelViewRow0;
+layout (location = 5) in vec4 ModelViewRow1;
+layout (location = 6) in vec4 ModelViewRow2;
+layout (location = 7) in vec4 NormalRow0;
+layout (location = 8) in vec4 NormalRow1;
+layout (location = 9) in vec4 NormalRow2;
+// Decoding of the mesh's vertex format: quantized positions are integers within the mesh bounds
+layout (location = 10) in vec4 PositionScale;
+layout (location = 11) in vec4 PositionBias;
 
 // varying variables will be passed to the fragment shader. This values also get interpolated between vertices
 out vec3 normalInt;
 out vec3 vertPosInt;
 out vec3 color;
+#ifdef TEXTURED
 out vec2 UVcoords;
+#endif
 
-void main()
+// Unfolds an octahedral encoded normal back onto the unit sphere
+vec3 decodeNormal(vec2 e)
 {
-    // Compute modelview matrix
-    mat4 modelViewMatrix = ViewMatrix * TransformMatrix;
-    mat4 modelViewProjectionMatrix = ProjectionMatrix * modelViewMatrix;
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
 
-    // Compute a 4*4 normal matrix
-    // this fixes transformations made on the model, which would make
-    // the normal vector not perpendicular
-    mat4 normalMatrix = transpose(inverse(modelViewMatrix));
+void main()
+{
+    vec4 objectPosition = vec4(Position * PositionScale.xyz + PositionBias.xyz, 1.0);
 
-    // Compute vertex position in Model space
-    vec4 position = modelViewMatrix * vec4(Position,1.0);
+    // Compute vertex position in view space
+    vec3 position = vec3(dot(ModelViewRow0, objectPosition),
+                         dot(ModelViewRow1, objectPosition),
+                         dot(ModelViewRow2, objectPosition));
 
-    // Normal (N)
-    normalInt = normalize((normalMatrix * vec4(normalize(Normal), 1.0)).xyz);
+    // Normal (N): the normal matrix keeps it perpendicular to scaled surfaces
+    // and, being 3x3, adds no translation
+    vec3 normal = decodeNormal(Normal);
+    normalInt = normalize(vec3(dot(NormalRow0.xyz, normal),
+                               dot(NormalRow1.xyz, normal),
+                               dot(NormalRow2.xyz, normal)));
 
-    vertPosInt = position.xyz;
+    vertPosInt = position;
 
     color = Color;
+#ifdef TEXTURED
     UVcoords = UV;
+#endif
 
-    gl_Position = modelViewProjectionMatrix * vec4(Position, 1.0);
+    gl_Position = ProjectionMatrix * vec4(position, 1.0);
 }
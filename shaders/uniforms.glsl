@@ -0,0 +1,15 @@
+// Uniform blocks shared by all programs, in one buffer per frame (see UniformBuffer); matrices are row-major
+layout (std140, row_major) uniform CameraBlock
+{
+    mat4 ProjectionMatrix;
+    mat4 ViewMatrix;
+};
+
+layout (std140) uniform LightBlock
+{
+    vec4 LightPosition;
+    vec4 LightColor;
+    float AmbientFactor;
+    float DiffuseFactor;
+    float SpecularFactor;
+};
@@ -0,0 +1,124 @@
+/******************************************************************
+*
+* FrustumCulling.cpp
+*
+* Description: View frustum planes from a projection and view
+* matrix, bounding spheres in world space and a sphere/frustum test
+* that checks four spheres at once with SSE (one at a time where SSE
+* is missing).
+*
+*******************************************************************/
+
+#include <cmath>
+
+#include "FrustumCulling.hpp"
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+/******************************************************************
+*
+* @brief Extracts the frustum planes from the rows of the combined
+* matrix (Gribb and Hartmann); planes are normalized so that the
+* sphere test can compare distances with radii
+*
+*******************************************************************/
+void ExtractFrustum(const float *projection, const float *view, Frustum *frustum)
+{
+    float m[16];
+    for (int r = 0; r < 4; r++)
+        for (int c = 0; c < 4; c++)
+            m[r * 4 + c] = projection[r * 4] * view[c] + projection[r * 4 + 1] * view[4 + c] +
+                           projection[r * 4 + 2] * view[8 + c] + projection[r * 4 + 3] * view[12 + c];
+
+    /* left, right, bottom, top, near, far: row 3 plus or minus rows 0, 1 and 2 */
+    for (int p = 0; p < 6; p++)
+    {
+        int row = p / 2;
+        float sign = p % 2 == 0 ? 1.0f : -1.0f;
+        float *plane = frustum->planes[p];
+        for (int c = 0; c < 4; c++)
+            plane[c] = m[12 + c] + sign * m[row * 4 + c];
+
+        float length = sqrtf(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+        if (length > 0)
+            for (int c = 0; c < 4; c++)
+                plane[c] /= length;
+    }
+}
+
+void TransformSphere(const float *model, const float *center, float radius, float *world)
+{
+    float scale = 0;
+    for (int r = 0; r < 3; r++)
+    {
+        world[r] = model[r * 4] * center[0] + model[r * 4 + 1] * center[1] + model[r * 4 + 2] * center[2] +
+                   model[r * 4 + 3];
+
+        float column = sqrtf(model[r] * model[r] + model[4 + r] * model[4 + r] + model[8 + r] * model[8 + r]);
+        if (column > scale)
+            scale = column;
+    }
+    world[3] = radius * scale;
+}
+
+size_t CullSpheresScalar(const Frustum *frustum, const SphereArray *spheres, unsigned char *visible)
+{
+    size_t count = 0;
+    for (size_t i = 0; i < spheres->count; i++)
+    {
+        int inside = 1;
+        for (int p = 0; p < 6 && inside; p++)
+        {
+            const float *plane = frustum->planes[p];
+            float distance = plane[0] * spheres->x[i] + plane[1] * spheres->y[i] + plane[2] * spheres->z[i] +
+                             plane[3];
+            inside = distance >= -spheres->radius[i];
+        }
+        visible[i] = inside;
+        count += inside;
+    }
+    return count;
+}
+
+/******************************************************************
+*
+* @brief Tests FRUSTUM_CULLING_WIDTH spheres per step against all six
+* planes; the arrays must be padded to a multiple of that width
+* (the padding is tested as well, so it should hold empty spheres)
+*
+*******************************************************************/
+size_t CullSpheres(const Frustum *frustum, const SphereArray *spheres, unsigned char *visible)
+{
+#ifdef __SSE__
+    size_t count = 0;
+    for (size_t i = 0; i < spheres->count; i += FRUSTUM_CULLING_WIDTH)
+    {
+        __m128 x = _mm_loadu_ps(spheres->x + i);
+        __m128 y = _mm_loadu_ps(spheres->y + i);
+        __m128 z = _mm_loadu_ps(spheres->z + i);
+        __m128 negativeRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(spheres->radius + i));
+
+        __m128 inside = _mm_cmpeq_ps(_mm_setzero_ps(), _mm_setzero_ps());  // all lanes set
+        for (int p = 0; p < 6; p++)
+        {
+            const float *plane = frustum->planes[p];
+            __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane[0]), x),
+                                                    _mm_mul_ps(_mm_set1_ps(plane[1]), y)),
+                                         _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane[2]), z), _mm_set1_ps(plane[3])));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negativeRadius));
+        }
+
+        int mask = _mm_movemask_ps(inside);
+        for (int k = 0; k < FRUSTUM_CULLING_WIDTH && i + k < spheres->count; k++)
+        {
+            visible[i + k] = (mask >> k) & 1;
+            count += visible[i + k];
+        }
+    }
+    return count;
+#else
+    return CullSpheresScalar(frustum, spheres, visible);
+#endif
+}
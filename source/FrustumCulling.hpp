@@ -0,0 +1,48 @@
+/******************************************************************
+*
+* FrustumCulling.hpp
+*
+* Description: View frustum planes from a projection and view
+* matrix, bounding spheres in world space and a sphere/frustum test
+* that checks four spheres at once with SSE (one at a time where SSE
+* is missing).
+*
+*******************************************************************/
+
+#ifndef FRUSTUM_CULLING_H
+#define FRUSTUM_CULLING_H
+
+#include <cstddef>
+
+/* Spheres tested together by the SIMD path */
+#define FRUSTUM_CULLING_WIDTH 4
+
+/* Planes (a, b, c, d) with normals pointing inside: ax + by + cz + d >= 0 for points in the frustum */
+typedef struct
+{
+    float planes[6][4];
+} Frustum;
+
+/* Bounding spheres in structure of arrays form, padded to FRUSTUM_CULLING_WIDTH */
+typedef struct
+{
+    float *x;
+    float *y;
+    float *z;
+    float *radius;
+    size_t count;
+} SphereArray;
+
+/* Extracts the planes of projection * view (both row-major, as in Matrix.h) */
+void ExtractFrustum(const float *projection, const float *view, Frustum *frustum);
+
+/* Transforms a sphere from mesh space into world space; the radius grows with the largest scale of the model */
+void TransformSphere(const float *model, const float *center, float radius, float *world);
+
+/* Sets visible[i] for every sphere that intersects the frustum; returns the number of visible spheres */
+size_t CullSpheres(const Frustum *frustum, const SphereArray *spheres, unsigned char *visible);
+
+/* The same test one sphere at a time, for comparison */
+size_t CullSpheresScalar(const Frustum *frustum, const SphereArray *spheres, unsigned char *visible);
+
+#endif
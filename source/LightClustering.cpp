@@ -0,0 +1,378 @@
+/******************************************************************
+*
+* LightClustering.cpp
+*
+* Description: Bins point lights into a grid of view space clusters
+* (tiles of the screen, sliced exponentially in depth) for clustered
+* forward shading. Light bounds are computed four lights at a time
+* with SSE (one at a time where SSE is missing) and the depth slices
+* are binned on several threads.
+*
+*******************************************************************/
+
+#include <cmath>
+
+#include "LightClustering.hpp"
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+using namespace std;
+
+void SetupClusterGrid(const float *view, const float *projection, ClusterGrid *grid)
+{
+    for (int i = 0; i < 16; i++)
+        grid->view[i] = view[i];
+
+    /* SetPerspectiveMatrix: row 2 is (0, 0, -(f + n) / (f - n), -2fn / (f - n)) */
+    grid->projectionX = projection[0];
+    grid->projectionY = projection[5];
+    grid->nearPlane = projection[11] / (projection[10] - 1.0f);
+    grid->farPlane = projection[11] / (projection[10] + 1.0f);
+    grid->sliceScale = LIGHT_CLUSTER_Z / logf(grid->farPlane / grid->nearPlane);
+}
+
+/* Returns the tile of a normalized device coordinate, as the fragment shader computes it */
+static int tileOf(float ndc, int tiles)
+{
+    int tile = (int) floorf((ndc * 0.5f + 0.5f) * tiles);
+    return tile < 0 ? 0 : (tile >= tiles ? tiles - 1 : tile);
+}
+
+/* Returns the depth slice of a distance in front of the camera, as the fragment shader computes it */
+static int sliceOf(const ClusterGrid *grid, float depth)
+{
+    int slice = (int) floorf(logf(depth / grid->nearPlane) * grid->sliceScale);
+    return slice < 0 ? 0 : (slice >= LIGHT_CLUSTER_Z ? LIGHT_CLUSTER_Z - 1 : slice);
+}
+
+/* Converts the depth range and the normalized device coordinate rectangle a light covers into clusters */
+static void toClusters(const ClusterGrid *grid, float nearDepth, float farDepth, float minX, float maxX,
+                       float minY, float maxY, ClusterBounds *bounds)
+{
+    bounds->min[0] = tileOf(minX, LIGHT_CLUSTER_X);
+    bounds->max[0] = tileOf(maxX, LIGHT_CLUSTER_X);
+    bounds->min[1] = tileOf(minY, LIGHT_CLUSTER_Y);
+    bounds->max[1] = tileOf(maxY, LIGHT_CLUSTER_Y);
+    bounds->min[2] = sliceOf(grid, nearDepth);
+    bounds->max[2] = sliceOf(grid, farDepth);
+}
+
+/******************************************************************
+*
+* @brief Bounds the lights one at a time. A sphere at view space
+* depth d with radius r covers the depths from d - r to d + r (cut
+* to the near and far plane); its box, divided by those depths,
+* gives a screen rectangle that contains its projection.
+*
+*******************************************************************/
+size_t BoundLightsScalar(const PointLight *lights, size_t count, const ClusterGrid *grid, ClusterLight *visible,
+                         ClusterBounds *bounds)
+{
+    const float *view = grid->view;
+    size_t kept = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        const PointLight &light = lights[i];
+        float position[3];
+        for (int r = 0; r < 3; r++)
+            position[r] = (view[r * 4] * light.position[0] + view[r * 4 + 1] * light.position[1]) +
+                          (view[r * 4 + 2] * light.position[2] + view[r * 4 + 3]);
+
+        /* the camera looks down -z */
+        float nearDepth = fmaxf(-position[2] - light.radius, grid->nearPlane);
+        float farDepth = fminf(-position[2] + light.radius, grid->farPlane);
+        if (nearDepth > farDepth)
+            continue;
+
+        float minX = grid->projectionX * fminf((position[0] - light.radius) / nearDepth,
+                                               (position[0] - light.radius) / farDepth);
+        float maxX = grid->projectionX * fmaxf((position[0] + light.radius) / nearDepth,
+                                               (position[0] + light.radius) / farDepth);
+        float minY = grid->projectionY * fminf((position[1] - light.radius) / nearDepth,
+                                               (position[1] - light.radius) / farDepth);
+        float maxY = grid->projectionY * fmaxf((position[1] + light.radius) / nearDepth,
+                                               (position[1] + light.radius) / farDepth);
+        if (maxX < -1.0f || minX > 1.0f || maxY < -1.0f || minY > 1.0f)
+            continue;
+
+        ClusterLight &out = visible[kept];
+        for (int k = 0; k < 3; k++)
+        {
+            out.position[k] = position[k];
+            out.color[k] = light.color[k] * light.intensity;
+        }
+        out.radius = light.radius;
+        out.color[3] = 0.0f;
+        toClusters(grid, nearDepth, farDepth, minX, maxX, minY, maxY, &bounds[kept]);
+        kept++;
+    }
+    return kept;
+}
+
+/******************************************************************
+*
+* @brief Bounds LIGHT_CLUSTER_WIDTH lights per step: their positions
+* and radii are transposed into one register per component, moved to
+* view space and projected together; the remaining lights take the
+* scalar path. Only the conversion to cluster indices (a logarithm
+* for the depth slices) is done per light.
+*
+*******************************************************************/
+size_t BoundLights(const PointLight *lights, size_t count, const ClusterGrid *grid, ClusterLight *visible,
+                   ClusterBounds *bounds)
+{
+#ifdef __SSE__
+    const float *view = grid->view;
+    __m128 nearPlane = _mm_set1_ps(grid->nearPlane);
+    __m128 farPlane = _mm_set1_ps(grid->farPlane);
+    __m128 projectionX = _mm_set1_ps(grid->projectionX);
+    __m128 projectionY = _mm_set1_ps(grid->projectionY);
+    __m128 one = _mm_set1_ps(1.0f);
+    __m128 minusOne = _mm_set1_ps(-1.0f);
+
+    size_t kept = 0;
+    size_t i = 0;
+    for (; i + LIGHT_CLUSTER_WIDTH <= count; i += LIGHT_CLUSTER_WIDTH)
+    {
+        /* position and radius are the first four floats of a light */
+        __m128 x = _mm_loadu_ps(lights[i].position);
+        __m128 y = _mm_loadu_ps(lights[i + 1].position);
+        __m128 z = _mm_loadu_ps(lights[i + 2].position);
+        __m128 radius = _mm_loadu_ps(lights[i + 3].position);
+        _MM_TRANSPOSE4_PS(x, y, z, radius);
+
+        __m128 position[3];
+        for (int r = 0; r < 3; r++)
+            position[r] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(view[r * 4]), x),
+                                                _mm_mul_ps(_mm_set1_ps(view[r * 4 + 1]), y)),
+                                     _mm_add_ps(_mm_mul_ps(_mm_set1_ps(view[r * 4 + 2]), z),
+                                                _mm_set1_ps(view[r * 4 + 3])));
+
+        __m128 depth = _mm_sub_ps(_mm_setzero_ps(), position[2]);
+        __m128 nearDepth = _mm_max_ps(_mm_sub_ps(depth, radius), nearPlane);
+        __m128 farDepth = _mm_min_ps(_mm_add_ps(depth, radius), farPlane);
+
+        __m128 low = _mm_sub_ps(position[0], radius);
+        __m128 high = _mm_add_ps(position[0], radius);
+        __m128 minX = _mm_mul_ps(projectionX, _mm_min_ps(_mm_div_ps(low, nearDepth), _mm_div_ps(low, farDepth)));
+        __m128 maxX = _mm_mul_ps(projectionX, _mm_max_ps(_mm_div_ps(high, nearDepth), _mm_div_ps(high, farDepth)));
+        low = _mm_sub_ps(position[1], radius);
+        high = _mm_add_ps(position[1], radius);
+        __m128 minY = _mm_mul_ps(projectionY, _mm_min_ps(_mm_div_ps(low, nearDepth), _mm_div_ps(low, farDepth)));
+        __m128 maxY = _mm_mul_ps(projectionY, _mm_max_ps(_mm_div_ps(high, nearDepth), _mm_div_ps(high, farDepth)));
+
+        __m128 inside = _mm_and_ps(_mm_cmple_ps(nearDepth, farDepth),
+                                   _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(maxX, minusOne), _mm_cmple_ps(minX, one)),
+                                              _mm_and_ps(_mm_cmpge_ps(maxY, minusOne), _mm_cmple_ps(minY, one))));
+        int mask = _mm_movemask_ps(inside);
+        if (mask == 0)
+            continue;
+
+        float values[9][LIGHT_CLUSTER_WIDTH];
+        _mm_storeu_ps(values[0], position[0]);
+        _mm_storeu_ps(values[1], position[1]);
+        _mm_storeu_ps(values[2], position[2]);
+        _mm_storeu_ps(values[3], nearDepth);
+        _mm_storeu_ps(values[4], farDepth);
+        _mm_storeu_ps(values[5], minX);
+        _mm_storeu_ps(values[6], maxX);
+        _mm_storeu_ps(values[7], minY);
+        _mm_storeu_ps(values[8], maxY);
+
+        for (int k = 0; k < LIGHT_CLUSTER_WIDTH; k++)
+        {
+            if (!((mask >> k) & 1))
+                continue;
+
+            const PointLight &light = lights[i + k];
+            ClusterLight &out = visible[kept];
+            for (int c = 0; c < 3; c++)
+            {
+                out.position[c] = values[c][k];
+                out.color[c] = light.color[c] * light.intensity;
+            }
+            out.radius = light.radius;
+            out.color[3] = 0.0f;
+            toClusters(grid, values[3][k], values[4][k], values[5][k], values[6][k], values[7][k], values[8][k],
+                       &bounds[kept]);
+            kept++;
+        }
+    }
+
+    return kept + BoundLightsScalar(lights + i, count - i, grid, visible + kept, bounds + kept);
+#else
+    return BoundLightsScalar(lights, count, grid, visible, bounds);
+#endif
+}
+
+/******************************************************************
+*
+* @brief Starts the worker threads; the calling thread is one of
+* 'threads' (0: one per core, at most one per depth slice)
+*
+*******************************************************************/
+LightClusterer::LightClusterer(int threads) :
+        generation(0), remaining(0), stopping(0), current(nullptr)
+{
+    if (threads <= 0)
+        threads = (int) thread::hardware_concurrency();
+    threads = threads < 1 ? 1 : (threads > LIGHT_CLUSTER_Z ? LIGHT_CLUSTER_Z : threads);
+
+    jobs.resize(threads);
+    for (int j = 0; j < threads; j++)
+    {
+        jobs[j].firstSlice = LIGHT_CLUSTER_Z * j / threads;
+        jobs[j].endSlice = LIGHT_CLUSTER_Z * (j + 1) / threads;
+    }
+
+    for (int j = 1; j < threads; j++)
+        workers.emplace_back(&LightClusterer::work, this, j);
+}
+
+LightClusterer::~LightClusterer()
+{
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = 1;
+    }
+    wake.notify_all();
+    for (thread &worker : workers)
+        worker.join();
+}
+
+/* Bins the slices of one job whenever build() starts a new generation */
+void LightClusterer::work(int job)
+{
+    unsigned long seen = 0;
+    while (true)
+    {
+        {
+            unique_lock<mutex> guard(lock);
+            wake.wait(guard, [&] { return stopping || generation != seen; });
+            if (stopping)
+                return;
+            seen = generation;
+        }
+
+        binSlices(&jobs[job]);
+
+        lock_guard<mutex> guard(lock);
+        if (--remaining == 0)
+            done.notify_one();
+    }
+}
+
+/******************************************************************
+*
+* @brief Builds the lists of the clusters in a job's depth slices:
+* the lights are counted per cluster, the counts become offsets and
+* the lights are written in a second pass, in the order of 'lights'
+*
+*******************************************************************/
+void LightClusterer::binSlices(SliceJob *job)
+{
+    const vector<ClusterBounds> &bounds = current->bounds;
+    ClusterRange *ranges = current->ranges.data();
+    const int sliceSize = LIGHT_CLUSTER_X * LIGHT_CLUSTER_Y;
+
+    for (int c = job->firstSlice * sliceSize; c < job->endSlice * sliceSize; c++)
+        ranges[c] = {0, 0};
+
+    for (int pass = 0; pass < 2; pass++)
+    {
+        for (size_t i = 0; i < bounds.size(); i++)
+        {
+            const ClusterBounds &b = bounds[i];
+            int firstZ = b.min[2] > job->firstSlice ? b.min[2] : job->firstSlice;
+            int lastZ = b.max[2] < job->endSlice - 1 ? b.max[2] : job->endSlice - 1;
+            for (int z = firstZ; z <= lastZ; z++)
+                for (int y = b.min[1]; y <= b.max[1]; y++)
+                {
+                    ClusterRange *row = ranges + z * sliceSize + y * LIGHT_CLUSTER_X;
+                    for (int x = b.min[0]; x <= b.max[0]; x++)
+                    {
+                        if (pass == 1)
+                            job->indices[row[x].offset + row[x].count] = (uint16_t) i;
+                        row[x].count++;
+                    }
+                }
+        }
+
+        if (pass == 1)
+            break;
+
+        /* counts to offsets; the counts restart and end up where they were */
+        uint32_t offset = 0;
+        for (int c = job->firstSlice * sliceSize; c < job->endSlice * sliceSize; c++)
+        {
+            ranges[c].offset = offset;
+            offset += ranges[c].count;
+            ranges[c].count = 0;
+        }
+        job->indices.resize(offset);
+    }
+}
+
+/******************************************************************
+*
+* @brief Bins the lights for a view and a perspective projection
+* (both row-major); lights beyond LIGHT_CLUSTER_MAX_LIGHTS are
+* ignored. 'clusters' keeps its storage between frames.
+*
+*******************************************************************/
+void LightClusterer::build(const PointLight *lights, size_t count, const float *view, const float *projection,
+                           LightClusters *clusters)
+{
+    if (count > LIGHT_CLUSTER_MAX_LIGHTS)
+        count = LIGHT_CLUSTER_MAX_LIGHTS;
+
+    SetupClusterGrid(view, projection, &clusters->grid);
+    clusters->lights.resize(count);
+    clusters->bounds.resize(count);
+    size_t visible = BoundLights(lights, count, &clusters->grid, clusters->lights.data(), clusters->bounds.data());
+    clusters->lights.resize(visible);
+    clusters->bounds.resize(visible);
+    clusters->ranges.resize(LIGHT_CLUSTER_COUNT);
+    current = clusters;
+
+    /* a few lights are binned faster than the workers wake up */
+    if (visible < LIGHT_CLUSTER_PARALLEL_LIGHTS || workers.empty())
+    {
+        SliceJob all = {0, LIGHT_CLUSTER_Z, {}};
+        all.indices.swap(clusters->indices);
+        binSlices(&all);
+        all.indices.swap(clusters->indices);
+        return;
+    }
+
+    {
+        lock_guard<mutex> guard(lock);
+        remaining = workers.size();
+        generation++;
+    }
+    wake.notify_all();
+    binSlices(&jobs[0]);
+    {
+        unique_lock<mutex> guard(lock);
+        done.wait(guard, [&] { return remaining == 0; });
+    }
+
+    /* join the jobs' lists in slice order */
+    const int sliceSize = LIGHT_CLUSTER_X * LIGHT_CLUSTER_Y;
+    clusters->indices.clear();
+    for (SliceJob &job : jobs)
+    {
+        uint32_t base = clusters->indices.size();
+        for (int c = job.firstSlice * sliceSize; c < job.endSlice * sliceSize; c++)
+            clusters->ranges[c].offset += base;
+        clusters->indices.insert(clusters->indices.end(), job.indices.begin(), job.indices.end());
+    }
+}
+
+/** Returns the threads that bin, including the calling one */
+int LightClusterer::getThreads()
+{
+    return jobs.size();
+}
@@ -0,0 +1,146 @@
+/******************************************************************
+*
+* LightClustering.hpp
+*
+* Description: Bins point lights into a grid of view space clusters
+* (tiles of the screen, sliced exponentially in depth) for clustered
+* forward shading. Light bounds are computed four lights at a time
+* with SSE (one at a time where SSE is missing) and the depth slices
+* are binned on several threads.
+*
+*******************************************************************/
+
+#ifndef LIGHT_CLUSTERING_H
+#define LIGHT_CLUSTERING_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Clusters along the x and y axis of the screen and in depth */
+#define LIGHT_CLUSTER_X 16
+#define LIGHT_CLUSTER_Y 9
+#define LIGHT_CLUSTER_Z 24
+#define LIGHT_CLUSTER_COUNT (LIGHT_CLUSTER_X * LIGHT_CLUSTER_Y * LIGHT_CLUSTER_Z)
+
+/* Lights are referenced by 16 bit indices */
+#define LIGHT_CLUSTER_MAX_LIGHTS 65535
+
+/* Lights bounded together by the SIMD path */
+#define LIGHT_CLUSTER_WIDTH 4
+
+/* Fewer visible lights than this are binned on the calling thread alone */
+#define LIGHT_CLUSTER_PARALLEL_LIGHTS 128
+
+/* A point light in world space; it reaches 'radius' units, fading to zero there */
+typedef struct
+{
+    float position[3];
+    float radius;
+    float color[3];
+    float intensity;
+} PointLight;
+
+/* A light as the fragment shader reads it (two RGBA32F texels): view space position and radius,
+ * color times intensity */
+typedef struct
+{
+    float position[3];
+    float radius;
+    float color[4];
+} ClusterLight;
+
+/* Clusters a light reaches, from min to max (inclusive) in x, y and z */
+typedef struct
+{
+    uint8_t min[3];
+    uint8_t max[3];
+} ClusterBounds;
+
+/* First index and number of lights of a cluster */
+typedef struct
+{
+    uint32_t offset;
+    uint32_t count;
+} ClusterRange;
+
+/* View and projection the grid is built for; the projection must be a symmetric perspective */
+typedef struct
+{
+    float view[16];             // row-major, as in Matrix.h
+    float projectionX;          // scale of x / -z and y / -z to normalized device coordinates
+    float projectionY;
+    float nearPlane;
+    float farPlane;
+    float sliceScale;           // depth slices per unit of log(depth / nearPlane)
+} ClusterGrid;
+
+/* Result of LightClusterer::build, laid out as the fragment shader reads it */
+typedef struct
+{
+    ClusterGrid grid;
+    std::vector<ClusterLight> lights;   // the lights that reach the view frustum
+    std::vector<ClusterBounds> bounds;  // of 'lights'
+    std::vector<ClusterRange> ranges;   // LIGHT_CLUSTER_COUNT; x varies fastest, then y, then z
+    std::vector<uint16_t> indices;      // into 'lights'
+} LightClusters;
+
+/* Sets up the grid of a view and a perspective projection (both row-major) */
+void SetupClusterGrid(const float *view, const float *projection, ClusterGrid *grid);
+
+/* Moves the lights into view space and computes the clusters they reach; lights that reach none are left out.
+ * 'visible' and 'bounds' need room for all lights; returns the number of lights written to them */
+size_t BoundLights(const PointLight *lights, size_t count, const ClusterGrid *grid, ClusterLight *visible,
+                   ClusterBounds *bounds);
+
+/* The same one light at a time, for comparison */
+size_t BoundLightsScalar(const PointLight *lights, size_t count, const ClusterGrid *grid, ClusterLight *visible,
+                         ClusterBounds *bounds);
+
+/******************************************************************
+*
+* Builds the per-cluster light lists of a frame. The depth slices
+* are split into one contiguous range per thread; each thread counts
+* and fills the lists of its own clusters, so no thread writes where
+* another one does, and the ranges are joined afterwards in order.
+*
+*******************************************************************/
+class LightClusterer
+{
+private:
+    typedef struct
+    {
+        int firstSlice;
+        int endSlice;
+        std::vector<uint16_t> indices;  // offsets in 'ranges' are relative to these
+    } SliceJob;
+
+    std::vector<std::thread> workers;
+    std::vector<SliceJob> jobs;         // jobs[0] runs on the calling thread
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable done;
+    unsigned long generation;
+    int remaining;
+    int stopping;
+    LightClusters *current;
+
+    void work(int job);
+
+    void binSlices(SliceJob *job);
+
+public:
+    explicit LightClusterer(int threads = 0);
+
+    ~LightClusterer();
+
+    void build(const PointLight *lights, size_t count, const float *view, const float *projection,
+               LightClusters *clusters);
+
+    int getThreads();
+};
+
+#endif /* LIGHT_CLUSTERING_H */
@@ -0,0 +1,114 @@
+/******************************************************************
+*
+* MappedFile.cpp
+*
+* Description: Read-only memory mapping of whole files, used to
+* scan model files in place instead of copying them line by line.
+*
+*******************************************************************/
+
+#include <cstdio>
+
+#include "MappedFile.hpp"
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* Empty files can not be mapped, they are represented by this buffer */
+static const char empty_file[1] = {0};
+
+int map_file(mapped_file *file, const char *filename)
+{
+    file->data = nullptr;
+    file->size = 0;
+    file->handle = nullptr;
+
+#ifdef WIN32
+    HANDLE fd = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fd == INVALID_HANDLE_VALUE)
+        return 0;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(fd, &size))
+    {
+        CloseHandle(fd);
+        return 0;
+    }
+
+    if (size.QuadPart == 0)
+    {
+        CloseHandle(fd);
+        file->data = empty_file;
+        return 1;
+    }
+
+    HANDLE mapping = CreateFileMappingA(fd, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(fd);
+    if (mapping == nullptr)
+        return 0;
+
+    file->data = (const char *) MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (file->data == nullptr)
+    {
+        CloseHandle(mapping);
+        return 0;
+    }
+    file->size = (size_t) size.QuadPart;
+    file->handle = mapping;
+#else
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return 0;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return 0;
+    }
+
+    if (st.st_size == 0)
+    {
+        close(fd);
+        file->data = empty_file;
+        return 1;
+    }
+
+    void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return 0;
+
+    /* the whole file is scanned front to back exactly once */
+    madvise(data, st.st_size, MADV_SEQUENTIAL);
+
+    file->data = (const char *) data;
+    file->size = (size_t) st.st_size;
+#endif
+
+    return 1;
+}
+
+void unmap_file(mapped_file *file)
+{
+    if (file->data != nullptr && file->data != empty_file)
+    {
+#ifdef WIN32
+        UnmapViewOfFile(file->data);
+        CloseHandle((HANDLE) file->handle);
+#else
+        munmap((void *) file->data, file->size);
+#endif
+    }
+
+    file->data = nullptr;
+    file->size = 0;
+    file->handle = nullptr;
+}
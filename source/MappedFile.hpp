@@ -0,0 +1,26 @@
+/******************************************************************
+*
+* MappedFile.hpp
+*
+* Description: Read-only memory mapping of whole files, used to
+* scan model files in place instead of copying them line by line.
+*
+*******************************************************************/
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+
+typedef struct
+{
+    const char *data;
+    size_t size;
+    void *handle; /* platform specific mapping handle */
+} mapped_file;
+
+/* Maps 'filename' read-only; returns 0 if the file can not be mapped */
+int map_file(mapped_file *file, const char *filename);
+void unmap_file(mapped_file *file);
+
+#endif
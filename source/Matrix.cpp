@@ -155,7 +155,7 @@ void SetTranslation(float x, float y, float z, float *result)
 *
 *******************************************************************/
 
-void MultiplyMatrix(float *m1, float *m2, float *result)
+void MultiplyMatrix(const float *m1, const float *m2, float *result)
 {
     int i;
     float temp[16];
@@ -187,6 +187,35 @@ void MultiplyMatrix(float *m1, float *m2, float *result)
 }
 
 
+/******************************************************************
+*
+* SetNormalMatrix
+*
+* Inverse transpose of the upper-left 3x3 part of a (row-major)
+* model-view matrix, as a row-major 3x3 matrix: transforms normals
+* so that they stay perpendicular to non-uniformly scaled surfaces,
+* without the translation. Computed from the cofactors, which are
+* the inverse transpose up to the factor 1 / determinant.
+*
+*******************************************************************/
+
+void SetNormalMatrix(const float *m, float *result)
+{
+    float temp[9] =
+            {
+                    m[5] * m[10] - m[6] * m[9], m[6] * m[8] - m[4] * m[10], m[4] * m[9] - m[5] * m[8],
+                    m[2] * m[9] - m[1] * m[10], m[0] * m[10] - m[2] * m[8], m[1] * m[8] - m[0] * m[9],
+                    m[1] * m[6] - m[2] * m[5], m[2] * m[4] - m[0] * m[6], m[0] * m[5] - m[1] * m[4]
+            };
+
+    float determinant = m[0] * temp[0] + m[1] * temp[1] + m[2] * temp[2];
+    float scale = determinant != 0 ? 1.0f / determinant : 1.0f;
+
+    for (int i = 0; i < 9; i++)
+        result[i] = temp[i] * scale;
+}
+
+
 /******************************************************************
 *
 * SetPerspectiveMatrix
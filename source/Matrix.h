@@ -26,7 +26,9 @@ void SetRotationZ(float anglez, float *result);
 
 void SetTranslation(float x, float y, float z, float *result);
 
-void MultiplyMatrix(float *m1, float *m2, float *result);
+void MultiplyMatrix(const float *m1, const float *m2, float *result);
+
+void SetNormalMatrix(const float *modelView, float *result);
 
 void SetPerspectiveMatrix(float fov, float aspect, float nearPlane, float farPlane, float *result);
 
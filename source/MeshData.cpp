@@ -0,0 +1,723 @@
+/******************************************************************
+*
+* MeshData.cpp
+*
+* Description: GPU-ready vertex and index streams built from OBJ
+* data, and the versioned binary mesh cache (.meshbin) that stores
+* them so that later launches can map them instead of re-parsing.
+*
+*******************************************************************/
+
+#include <atomic>
+#include <cfloat>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <sys/stat.h>
+
+#ifdef WIN32
+#include <direct.h>
+#endif
+
+#include "MeshData.hpp"
+#include "MeshOptimizer.hpp"
+#include "MeshSimplifier.hpp"
+
+/* Offsets of the streams in a cache file are aligned to this */
+#define MESHBIN_ALIGN 16
+
+/* Share of the triangles kept by each level of detail */
+static const float MeshLodRatios[MESH_MAX_LODS] = {1.0f, 0.5f, 0.25f, 0.1f};
+
+/*
+ * Open addressing table mapping a vertex key (N ints) to its index in
+ * the output streams; used to find corners that share a vertex.
+ */
+template<int N>
+class WeldTable
+{
+public:
+    explicit WeldTable(size_t expected)
+    {
+        size_t capacity = 16;
+        while (capacity < expected * 2)
+            capacity *= 2;
+        mask = capacity - 1;
+        keys.resize(capacity * N);
+        values.assign(capacity, -1);
+    }
+
+    /* Returns the index stored for key, or stores and returns 'next' */
+    int insert(const int32_t *key, int next)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (int i = 0; i < N; i++)
+            hash = (hash ^ (uint32_t) key[i]) * 1099511628211ull;
+
+        for (size_t slot = (hash ^ (hash >> 29)) & mask;; slot = (slot + 1) & mask)
+        {
+            if (values[slot] < 0)
+            {
+                memcpy(&keys[slot * N], key, sizeof(int32_t) * N);
+                values[slot] = next;
+                return next;
+            }
+            if (memcmp(&keys[slot * N], key, sizeof(int32_t) * N) == 0)
+                return values[slot];
+        }
+    }
+
+private:
+    size_t mask;
+    std::vector<int32_t> keys;
+    std::vector<int> values;
+};
+
+static int32_t Quantize(float value, float epsilon)
+{
+    return (int32_t) floorf(value / epsilon + 0.5f);
+}
+
+/******************************************************************
+*
+* @brief Builds indexed vertex streams from parsed OBJ data. Every
+* distinct (position, uv, normal) combination becomes one vertex;
+* with a weld epsilon, corners whose attribute values fall into the
+* same epsilon cell are merged as well, even if the OBJ file stores
+* them under different indices.
+*
+* @param data = parsed OBJ scene
+* @param scale = scale factor applied to the vertices
+* @param options = import options (weld epsilon, levels of detail,
+* optimization, vertex format)
+* @param mesh = receives the streams and bounds
+*******************************************************************/
+int BuildMeshData(const obj_scene_data *data, float scale, const MeshImportOptions *options, MeshData *mesh)
+{
+    int faceCount = data->face_count;
+    float epsilon = options->weldEpsilon;
+
+    mesh->positions.clear();
+    mesh->normals.clear();
+    mesh->uvs.clear();
+    mesh->indices.assign(faceCount * 3, 0);
+    mesh->scale = scale;
+    mesh->weldEpsilon = epsilon;
+    mesh->optimized = options->optimize;
+    mesh->simplified = options->simplify;
+
+    WeldTable<3> exact(epsilon > 0 ? 0 : faceCount * 3);
+    WeldTable<8> welded(epsilon > 0 ? faceCount * 3 : 0);
+
+    /* for each triangle... */
+    for (int i = 0; i < faceCount; i++)
+    {
+        const int *vertexIndex = data->face_vertex_index + i * MAX_VERTEX_COUNT;
+        const int *normalIndex = data->face_normal_index + i * MAX_VERTEX_COUNT;
+        const int *uvIndex = data->face_texture_index + i * MAX_VERTEX_COUNT;
+
+        for (int j = 0; j < 3; j++)
+        {
+            const float *p = data->vertex_positions + vertexIndex[j] * 3;
+            float position[3] = {p[0] * scale, p[1] * scale, p[2] * scale};
+
+            /* the position stands in for a missing normal */
+            const float *normal = normalIndex[0] != -1 ? data->vertex_normals + normalIndex[j] * 3 : position;
+
+            static const float noUV[2] = {0.0f, 0.0f};
+            const float *uv = uvIndex[0] != -1 ? data->vertex_uvs + uvIndex[j] * 2 : noUV;
+
+            int next = mesh->positions.size() / 3;
+            int vertex;
+            if (epsilon > 0)
+            {
+                int32_t key[8] = {
+                        Quantize(position[0], epsilon), Quantize(position[1], epsilon), Quantize(position[2], epsilon),
+                        Quantize(normal[0], epsilon), Quantize(normal[1], epsilon), Quantize(normal[2], epsilon),
+                        Quantize(uv[0], epsilon), Quantize(uv[1], epsilon)
+                };
+                vertex = welded.insert(key, next);
+            } else
+            {
+                int32_t key[3] = {vertexIndex[j], uvIndex[0] != -1 ? uvIndex[j] : -1,
+                                  normalIndex[0] != -1 ? normalIndex[j] : -1};
+                vertex = exact.insert(key, next);
+            }
+
+            if (vertex == next)
+            {
+                mesh->positions.insert(mesh->positions.end(), position, position + 3);
+                mesh->normals.insert(mesh->normals.end(), normal, normal + 3);
+                mesh->uvs.insert(mesh->uvs.end(), uv, uv + 2);
+            }
+
+            mesh->indices[i * 3 + j] = vertex;
+        }
+    }
+
+    for (int k = 0; k < 3; k++)
+    {
+        mesh->boundsMin[k] = faceCount > 0 ? FLT_MAX : 0.0f;
+        mesh->boundsMax[k] = faceCount > 0 ? -FLT_MAX : 0.0f;
+    }
+    for (size_t v = 0; v < mesh->positions.size(); v += 3)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            if (mesh->positions[v + k] < mesh->boundsMin[k])
+                mesh->boundsMin[k] = mesh->positions[v + k];
+            if (mesh->positions[v + k] > mesh->boundsMax[k])
+                mesh->boundsMax[k] = mesh->positions[v + k];
+        }
+    }
+
+    mesh->lodCount = 1;
+    mesh->lods[0].indexOffset = 0;
+    mesh->lods[0].indexCount = mesh->indices.size();
+    mesh->lods[0].error = 0.0f;
+
+    if (options->simplify)
+        GenerateMeshLods(mesh);
+
+    if (options->optimize)
+        OptimizeMeshData(mesh);
+
+    PackMeshIndices(mesh);
+    PackMeshVertices(mesh, options->quantize);
+    return 1;
+}
+
+/******************************************************************
+*
+* @brief Appends the simplified levels of detail of a mesh to its
+* index stream. Levels that could not be simplified noticeably
+* beyond the previous one (e.g. because seams are locked) are left
+* out, so lodCount can be smaller than MESH_MAX_LODS.
+*
+*******************************************************************/
+void GenerateMeshLods(MeshData *mesh)
+{
+    std::vector<uint32_t> levels[MESH_MAX_LODS - 1];
+    float errors[MESH_MAX_LODS - 1];
+
+    SimplifyMeshLods(mesh->indices, mesh->positions.data(), mesh->positions.size() / 3, MeshLodRatios + 1,
+                     MESH_MAX_LODS - 1, levels, errors);
+
+    for (int level = 0; level < MESH_MAX_LODS - 1; level++)
+    {
+        const MeshLod &previous = mesh->lods[mesh->lodCount - 1];
+        if (levels[level].empty() || levels[level].size() > previous.indexCount * 0.9)
+            continue;
+
+        MeshLod &lod = mesh->lods[mesh->lodCount++];
+        lod.indexOffset = mesh->indices.size();
+        lod.indexCount = levels[level].size();
+        lod.error = errors[level];
+        mesh->indices.insert(mesh->indices.end(), levels[level].begin(), levels[level].end());
+    }
+}
+
+/******************************************************************
+*
+* @brief Reorders the triangles of every level of detail for the
+* post-transform vertex cache and against overdraw, then renumbers
+* the vertices in the order the full level uses them
+*
+*******************************************************************/
+void OptimizeMeshData(MeshData *mesh)
+{
+    uint32_t vertexCount = mesh->positions.size() / 3;
+
+    for (uint32_t l = 0; l < mesh->lodCount; l++)
+    {
+        std::vector<uint32_t>::iterator begin = mesh->indices.begin() + mesh->lods[l].indexOffset;
+        std::vector<uint32_t> indices(begin, begin + mesh->lods[l].indexCount);
+
+        std::vector<uint32_t> clusters = OptimizeVertexCache(&indices, vertexCount, MESH_OPTIMIZER_CACHE_SIZE);
+        OptimizeOverdraw(&indices, clusters, mesh->positions.data(), vertexCount);
+        std::copy(indices.begin(), indices.end(), begin);
+    }
+
+    std::vector<uint32_t> remap = OptimizeVertexFetch(&mesh->indices, vertexCount);
+    RemapVertexStream(&mesh->positions, remap, 3);
+    RemapVertexStream(&mesh->normals, remap, 3);
+    RemapVertexStream(&mesh->uvs, remap, 2);
+}
+
+/******************************************************************
+*
+* @brief Chooses the index width of a mesh: 16 bit while every vertex
+* can be addressed with it, 32 bit otherwise
+*
+*******************************************************************/
+void PackMeshIndices(MeshData *mesh)
+{
+    if (mesh->positions.size() / 3 <= 65536)
+    {
+        mesh->indices16.assign(mesh->indices.begin(), mesh->indices.end());
+        mesh->indexSize = sizeof(uint16_t);
+    } else
+    {
+        mesh->indices16.clear();
+        mesh->indexSize = sizeof(uint32_t);
+    }
+}
+
+/* Rounds to the nearest half float; out of range values become infinity */
+static uint16_t FloatToHalf(float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    uint32_t sign = (bits >> 16) & 0x8000;
+    int32_t exponent = (int32_t) ((bits >> 23) & 0xff) - 127 + 15;
+    uint32_t mantissa = bits & 0x7fffff;
+
+    if (((bits >> 23) & 0xff) == 0xff)
+        return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+    if (exponent >= 31)
+        return sign | 0x7c00;
+
+    if (exponent <= 0)
+    {
+        /* subnormal half */
+        if (exponent < -10)
+            return sign;
+        mantissa |= 0x800000;
+        uint32_t shift = 14 - exponent;
+        uint32_t half = mantissa >> shift;
+        if ((mantissa >> (shift - 1)) & 1)
+            half++;
+        return sign | half;
+    }
+
+    uint32_t half = sign | (exponent << 10) | (mantissa >> 13);
+    if (mantissa & 0x1000)
+        half++;   // a carry into the exponent still rounds correctly
+    return half;
+}
+
+static int16_t ToSnorm16(float value)
+{
+    value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+    return (int16_t) lrintf(value * 32767.0f);
+}
+
+/* Maps a direction onto the octahedron and unfolds it into [-1, 1]^2 */
+static void EncodeOctahedral(const float *normal, float *result)
+{
+    float length = fabsf(normal[0]) + fabsf(normal[1]) + fabsf(normal[2]);
+    if (length <= 0)
+    {
+        result[0] = result[1] = 0.0f;
+        return;
+    }
+
+    float x = normal[0] / length;
+    float y = normal[1] / length;
+    if (normal[2] < 0)
+    {
+        float foldedX = (1.0f - fabsf(y)) * (x >= 0 ? 1.0f : -1.0f);
+        float foldedY = (1.0f - fabsf(x)) * (y >= 0 ? 1.0f : -1.0f);
+        x = foldedX;
+        y = foldedY;
+    }
+    result[0] = x;
+    result[1] = y;
+}
+
+/******************************************************************
+*
+* @brief Interleaves the float streams of a mesh into the uploaded
+* vertex layout. Normals are octahedral encoded in both layouts. The
+* quantized layout stores positions as 16 bit integers spanning the
+* bounds (decoded with positionScale/positionBias), normals as snorm16
+* and uvs as half floats: 16 instead of 32 bytes per vertex.
+*
+*******************************************************************/
+void PackMeshVertices(MeshData *mesh, int quantize)
+{
+    size_t vertexCount = mesh->positions.size() / 3;
+
+    for (int k = 0; k < 3; k++)
+    {
+        float half = (mesh->boundsMax[k] - mesh->boundsMin[k]) * 0.5f;
+        mesh->positionBias[k] = quantize ? mesh->boundsMin[k] + half : 0.0f;
+        mesh->positionScale[k] = quantize ? (half > 0 ? half / 32767.0f : 1.0f) : 1.0f;
+    }
+
+    mesh->vertexFormat = quantize ? MESH_VERTEX_QUANTIZED : MESH_VERTEX_FLOAT;
+    mesh->vertexStride = quantize ? sizeof(MeshVertexQuantized) : sizeof(MeshVertexFloat);
+    mesh->vertices.assign(vertexCount * mesh->vertexStride, 0);
+
+    for (size_t v = 0; v < vertexCount; v++)
+    {
+        const float *position = &mesh->positions[v * 3];
+        const float *uv = &mesh->uvs[v * 2];
+        float normal[2];
+        EncodeOctahedral(&mesh->normals[v * 3], normal);
+
+        if (quantize)
+        {
+            MeshVertexQuantized vertex;
+            for (int k = 0; k < 3; k++)
+                vertex.position[k] = (int16_t) lrintf((position[k] - mesh->positionBias[k]) / mesh->positionScale[k]);
+            vertex.position[3] = 0;
+            vertex.normal[0] = ToSnorm16(normal[0]);
+            vertex.normal[1] = ToSnorm16(normal[1]);
+            vertex.uv[0] = FloatToHalf(uv[0]);
+            vertex.uv[1] = FloatToHalf(uv[1]);
+            memcpy(&mesh->vertices[v * sizeof(vertex)], &vertex, sizeof(vertex));
+        } else
+        {
+            MeshVertexFloat vertex = {{position[0], position[1], position[2]}, {normal[0], normal[1]}, {uv[0], uv[1]}};
+            memcpy(&mesh->vertices[v * sizeof(vertex)], &vertex, sizeof(vertex));
+        }
+    }
+}
+
+static const void *MeshIndexData(const MeshData *mesh)
+{
+    return mesh->indexSize == sizeof(uint16_t) ? (const void *) mesh->indices16.data()
+                                               : (const void *) mesh->indices.data();
+}
+
+/* Points a view at the streams of an in-memory mesh */
+void GetMeshView(const MeshData *mesh, MeshView *view)
+{
+    view->vertices = mesh->vertices.data();
+    view->indices = MeshIndexData(mesh);
+    view->vertexCount = mesh->positions.size() / 3;
+    view->indexCount = mesh->indices.size();
+    view->indexSize = mesh->indexSize;
+    view->vertexFormat = mesh->vertexFormat;
+    view->vertexStride = mesh->vertexStride;
+    memcpy(view->boundsMin, mesh->boundsMin, sizeof(view->boundsMin));
+    memcpy(view->boundsMax, mesh->boundsMax, sizeof(view->boundsMax));
+    memcpy(view->positionScale, mesh->positionScale, sizeof(view->positionScale));
+    memcpy(view->positionBias, mesh->positionBias, sizeof(view->positionBias));
+    view->scale = mesh->scale;
+    view->weldEpsilon = mesh->weldEpsilon;
+    view->optimized = mesh->optimized;
+    view->simplified = mesh->simplified;
+    view->lodCount = mesh->lodCount;
+    memcpy(view->lods, mesh->lods, sizeof(view->lods));
+    view->file.data = nullptr;
+    view->file.size = 0;
+    view->file.handle = nullptr;
+}
+
+/* Releases the cache file a view points into, if any */
+void CloseMeshView(MeshView *view)
+{
+    if (view->file.data != nullptr)
+        unmap_file(&view->file);
+}
+
+/******************************************************************
+*
+* @brief Collects modification time and size of an OBJ file, and
+* optionally a FNV-1a hash of its content
+*
+*******************************************************************/
+int GetMeshSourceInfo(const char *objPath, int withHash, MeshSourceInfo *info)
+{
+    struct stat st;
+    if (stat(objPath, &st) != 0)
+        return 0;
+
+    info->mtime = (uint64_t) st.st_mtime;
+    info->size = (uint64_t) st.st_size;
+    info->hash = 0;
+
+    if (withHash)
+    {
+        mapped_file file;
+        if (!map_file(&file, objPath))
+            return 0;
+
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < file.size; i++)
+        {
+            hash ^= (unsigned char) file.data[i];
+            hash *= 1099511628211ull;
+        }
+        info->hash = hash;
+
+        unmap_file(&file);
+    }
+
+    return 1;
+}
+
+static uint64_t AlignOffset(uint64_t offset)
+{
+    return (offset + MESHBIN_ALIGN - 1) & ~(uint64_t) (MESHBIN_ALIGN - 1);
+}
+
+static int WritePadded(FILE *out, const void *data, size_t size, uint64_t *offset)
+{
+    static const char zeros[MESHBIN_ALIGN] = {0};
+    uint64_t aligned = AlignOffset(*offset);
+
+    if (fwrite(zeros, 1, aligned - *offset, out) != aligned - *offset)
+        return 0;
+    if (size > 0 && fwrite(data, 1, size, out) != size)
+        return 0;
+
+    *offset = aligned + size;
+    return 1;
+}
+
+/******************************************************************
+*
+* @brief Writes a mesh to a .meshbin file; the file is written under
+* a temporary name and renamed so readers never see partial files
+*
+*******************************************************************/
+int WriteMeshBin(const char *path, const MeshData *mesh, const MeshSourceInfo *source)
+{
+    MeshBinHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MESHBIN_MAGIC, sizeof(header.magic));
+    header.version = MESHBIN_VERSION;
+    header.headerSize = sizeof(MeshBinHeader);
+    header.source = *source;
+    header.scale = mesh->scale;
+    header.weldEpsilon = mesh->weldEpsilon;
+    header.optimized = mesh->optimized;
+    header.simplified = mesh->simplified;
+    header.lodCount = mesh->lodCount;
+    memcpy(header.lods, mesh->lods, sizeof(header.lods));
+    header.vertexCount = mesh->positions.size() / 3;
+    header.indexCount = mesh->indices.size();
+    header.indexSize = mesh->indexSize;
+    header.vertexFormat = mesh->vertexFormat;
+    header.vertexStride = mesh->vertexStride;
+    memcpy(header.boundsMin, mesh->boundsMin, sizeof(header.boundsMin));
+    memcpy(header.boundsMax, mesh->boundsMax, sizeof(header.boundsMax));
+    memcpy(header.positionScale, mesh->positionScale, sizeof(header.positionScale));
+    memcpy(header.positionBias, mesh->positionBias, sizeof(header.positionBias));
+
+    header.vertexOffset = AlignOffset(sizeof(MeshBinHeader));
+    header.indexOffset = AlignOffset(header.vertexOffset + mesh->vertices.size());
+
+    /* unique per writer: the asset loader may build the same entry on two threads */
+    static std::atomic<unsigned> writers(0);
+    std::string tempPath = std::string(path) + "." + std::to_string(writers++) + ".tmp";
+    FILE *out = fopen(tempPath.c_str(), "wb");
+    if (out == nullptr)
+    {
+        fprintf(stderr, "Could not write mesh cache %s\n", tempPath.c_str());
+        return 0;
+    }
+
+    uint64_t offset = 0;
+    int success = WritePadded(out, &header, sizeof(header), &offset) &&
+                  WritePadded(out, mesh->vertices.data(), mesh->vertices.size(), &offset) &&
+                  WritePadded(out, MeshIndexData(mesh), mesh->indices.size() * mesh->indexSize, &offset);
+    success = (fclose(out) == 0) && success;
+
+    if (!success || rename(tempPath.c_str(), path) != 0)
+    {
+        fprintf(stderr, "Could not write mesh cache %s\n", path);
+        remove(tempPath.c_str());
+        return 0;
+    }
+
+    return 1;
+}
+
+/******************************************************************
+*
+* @brief Maps a .meshbin file and points the view into it; fails for
+* files of another version or with inconsistent offsets
+*
+*******************************************************************/
+int OpenMeshBin(const char *path, MeshView *view, MeshBinHeader *header)
+{
+    mapped_file file;
+    if (!map_file(&file, path))
+        return 0;
+
+    if (file.size < sizeof(MeshBinHeader))
+    {
+        unmap_file(&file);
+        return 0;
+    }
+
+    memcpy(header, file.data, sizeof(MeshBinHeader));
+
+    uint32_t stride = header->vertexFormat == MESH_VERTEX_QUANTIZED ? sizeof(MeshVertexQuantized)
+                                                                    : sizeof(MeshVertexFloat);
+    if (memcmp(header->magic, MESHBIN_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != MESHBIN_VERSION || header->headerSize != sizeof(MeshBinHeader) ||
+        (header->indexSize != sizeof(uint16_t) && header->indexSize != sizeof(uint32_t)) ||
+        (header->vertexFormat != MESH_VERTEX_FLOAT && header->vertexFormat != MESH_VERTEX_QUANTIZED) ||
+        header->vertexStride != stride ||
+        header->vertexOffset + (uint64_t) header->vertexCount * stride > file.size ||
+        header->indexOffset + (uint64_t) header->indexCount * header->indexSize > file.size ||
+        header->lodCount < 1 || header->lodCount > MESH_MAX_LODS)
+    {
+        unmap_file(&file);
+        return 0;
+    }
+
+    for (uint32_t l = 0; l < header->lodCount; l++)
+    {
+        if ((uint64_t) header->lods[l].indexOffset + header->lods[l].indexCount > header->indexCount)
+        {
+            unmap_file(&file);
+            return 0;
+        }
+    }
+
+    view->vertices = file.data + header->vertexOffset;
+    view->indices = file.data + header->indexOffset;
+    view->vertexCount = header->vertexCount;
+    view->indexCount = header->indexCount;
+    view->indexSize = header->indexSize;
+    view->vertexFormat = header->vertexFormat;
+    view->vertexStride = header->vertexStride;
+    memcpy(view->boundsMin, header->boundsMin, sizeof(view->boundsMin));
+    memcpy(view->boundsMax, header->boundsMax, sizeof(view->boundsMax));
+    memcpy(view->positionScale, header->positionScale, sizeof(view->positionScale));
+    memcpy(view->positionBias, header->positionBias, sizeof(view->positionBias));
+    view->scale = header->scale;
+    view->weldEpsilon = header->weldEpsilon;
+    view->optimized = header->optimized;
+    view->simplified = header->simplified;
+    view->lodCount = header->lodCount;
+    memcpy(view->lods, header->lods, sizeof(view->lods));
+    view->file = file;
+
+    return 1;
+}
+
+/******************************************************************
+*
+* @brief Returns the cache file used for an OBJ file at a given
+* scale, e.g. cache/banana.obj-0.25.meshbin; non-default import
+* options are part of the name, e.g. banana.obj-0.25-w0.001.meshbin
+* or banana.obj-0.25-raw-float-nolod.meshbin without optimization,
+* with float vertices and without levels of detail
+*
+*******************************************************************/
+std::string MeshCachePath(const std::string &objPath, float scale, const MeshImportOptions *options)
+{
+    size_t slash = objPath.find_last_of("/\\");
+    std::string name = slash == std::string::npos ? objPath : objPath.substr(slash + 1);
+
+    char suffix[96];
+    int length = snprintf(suffix, sizeof(suffix), "-%g", scale);
+    if (options->weldEpsilon > 0)
+        length += snprintf(suffix + length, sizeof(suffix) - length, "-w%g", options->weldEpsilon);
+    snprintf(suffix + length, sizeof(suffix) - length, "%s%s%s.meshbin", options->optimize ? "" : "-raw",
+             options->quantize ? "" : "-float", options->simplify ? "" : "-nolod");
+
+    return std::string(MESHBIN_CACHE_DIR) + "/" + name + suffix;
+}
+
+/* Records a new source mtime/size for a cache entry whose content hash still matches */
+static void UpdateMeshBinSource(const char *path, const MeshSourceInfo *source)
+{
+    FILE *out = fopen(path, "r+b");
+    if (out == nullptr)
+        return;
+
+    if (fseek(out, offsetof(MeshBinHeader, source), SEEK_SET) == 0)
+        fwrite(source, sizeof(MeshSourceInfo), 1, out);
+    fclose(out);
+}
+
+/* 'threads' limits the parser threads of large files, 0 for all cores; with 1 the file is parsed mapped */
+static int ParseObjToMeshData(const char *objPath, float scale, const MeshImportOptions *options, int threads,
+                              MeshData *mesh)
+{
+    obj_scene_data data;
+    obj_parse_mode mode = threads == 1 ? OBJ_PARSE_MAPPED : OBJ_PARSE_AUTO;
+    if (!parse_obj_scene_mode(&data, objPath, mode, threads))
+        return 0;
+
+    int success = BuildMeshData(&data, scale, options, mesh);
+    delete_obj_data(&data);
+    return success;
+}
+
+/* Converts an OBJ file into a .meshbin file (used by meshconv) */
+int ConvertObjToMeshBin(const char *objPath, float scale, const MeshImportOptions *options, const char *outPath)
+{
+    MeshSourceInfo source;
+    MeshData mesh;
+
+    if (!GetMeshSourceInfo(objPath, 1, &source) || !ParseObjToMeshData(objPath, scale, options, 0, &mesh))
+        return 0;
+
+    return WriteMeshBin(outPath, &mesh, &source);
+}
+
+/******************************************************************
+*
+* @brief Loads the streams of an OBJ file. An up to date cache file
+* is mapped directly; otherwise the OBJ is parsed into 'storage'
+* and the cache is rewritten. A cache entry is up to date when it
+* was built at the same scale from a source with the same mtime and
+* size, or - if those changed - with the same content hash.
+*
+* @param objPath = path of the OBJ file
+* @param scale = scale factor applied to the vertices
+* @param options = import options, part of the cache key
+* @param storage = holds the streams if they had to be rebuilt
+* @param view = receives the streams; release with CloseMeshView
+* @param parseThreads = threads that may parse a large OBJ file, 0
+* for all cores
+*******************************************************************/
+int LoadMesh(const std::string &objPath, float scale, const MeshImportOptions *options, MeshData *storage,
+             MeshView *view, int parseThreads)
+{
+    std::string cachePath = MeshCachePath(objPath, scale, options);
+    MeshSourceInfo source;
+    MeshBinHeader header;
+
+    if (!GetMeshSourceInfo(objPath.c_str(), 0, &source))
+    {
+        fprintf(stderr, "Could not find mesh file %s\n", objPath.c_str());
+        return 0;
+    }
+
+    if (OpenMeshBin(cachePath.c_str(), view, &header))
+    {
+        if (header.scale == scale && header.weldEpsilon == options->weldEpsilon &&
+            (int) header.optimized == options->optimize && (int) header.simplified == options->simplify &&
+            header.vertexFormat == (uint32_t) (options->quantize ? MESH_VERTEX_QUANTIZED : MESH_VERTEX_FLOAT))
+        {
+            if (header.source.mtime == source.mtime && header.source.size == source.size)
+                return 1;
+
+            /* touched but maybe not changed */
+            if (GetMeshSourceInfo(objPath.c_str(), 1, &source) && header.source.hash == source.hash)
+            {
+                UpdateMeshBinSource(cachePath.c_str(), &source);
+                return 1;
+            }
+        }
+        CloseMeshView(view);
+    }
+
+    if (!ParseObjToMeshData(objPath.c_str(), scale, options, parseThreads, storage))
+        return 0;
+
+    if (source.hash == 0)
+        GetMeshSourceInfo(objPath.c_str(), 1, &source);
+
+#ifdef WIN32
+    _mkdir(MESHBIN_CACHE_DIR);
+#else
+    mkdir(MESHBIN_CACHE_DIR, 0755);
+#endif
+    WriteMeshBin(cachePath.c_str(), storage, &source);
+
+    GetMeshView(storage, view);
+    return 1;
+}
@@ -0,0 +1,194 @@
+/******************************************************************
+*
+* MeshData.hpp
+*
+* Description: GPU-ready vertex and index streams built from OBJ
+* data, and the versioned binary mesh cache (.meshbin) that stores
+* them so that later launches can map them instead of re-parsing.
+*
+*******************************************************************/
+
+#ifndef MESH_DATA_H
+#define MESH_DATA_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "MappedFile.hpp"
+#include "OBJParser.hpp"
+
+#define MESHBIN_MAGIC "MESHBIN"
+#define MESHBIN_VERSION 6
+#define MESHBIN_CACHE_DIR "cache"
+
+/* Levels of detail per mesh: 100%, 50%, 25% and 10% of the triangles */
+#define MESH_MAX_LODS 4
+
+/* Options that change the built streams; part of the cache key */
+typedef struct
+{
+    float weldEpsilon;  // 0: share vertices with identical v/vt/vn indices only
+    int optimize;       // reorder triangles and vertices for the GPU (MeshOptimizer)
+    int quantize;       // MESH_VERTEX_QUANTIZED instead of MESH_VERTEX_FLOAT
+    int simplify;       // add simplified levels of detail (MeshSimplifier)
+} MeshImportOptions;
+
+static const MeshImportOptions DefaultMeshImportOptions = {0.0f, 1, 1, 1};
+
+/* Layouts of the interleaved vertex stream; normals are always octahedral
+ * encoded (two components) and positions decode as p * scale + bias */
+typedef enum
+{
+    MESH_VERTEX_FLOAT = 0,
+    MESH_VERTEX_QUANTIZED = 1
+} MeshVertexFormat;
+
+/* 28 bytes: float position, octahedral normal and uv */
+typedef struct
+{
+    float position[3];
+    float normal[2];
+    float uv[2];
+} MeshVertexFloat;
+
+/* 16 bytes: 16 bit integer position within the bounds (w is padding),
+ * snorm16 octahedral normal and half float uv */
+typedef struct
+{
+    int16_t position[4];
+    int16_t normal[2];
+    uint16_t uv[2];
+} MeshVertexQuantized;
+
+/* Range of one level of detail in the index stream */
+typedef struct
+{
+    uint32_t indexOffset;
+    uint32_t indexCount;
+    float error;        // how far the simplification moved the surface, in mesh units
+} MeshLod;
+
+/* Indexed vertex and index streams; the separate float streams are
+ * used while building, the interleaved stream is what is uploaded */
+typedef struct
+{
+    std::vector<float> positions;   // x, y, z per vertex, already scaled
+    std::vector<float> normals;     // x, y, z per vertex
+    std::vector<float> uvs;         // u, v per vertex
+    std::vector<uint32_t> indices;  // three per triangle, all levels of detail one after another
+    std::vector<uint16_t> indices16; // copy of indices if every index fits 16 bits
+    uint32_t indexSize;             // 2 or 4 bytes, as uploaded
+
+    std::vector<unsigned char> vertices; // interleaved MeshVertexFloat or MeshVertexQuantized
+    uint32_t vertexFormat;
+    uint32_t vertexStride;
+    float positionScale[3];
+    float positionBias[3];
+
+    float boundsMin[3];
+    float boundsMax[3];
+    float scale;
+    float weldEpsilon;
+    int optimized;
+    int simplified;
+
+    uint32_t lodCount;
+    MeshLod lods[MESH_MAX_LODS];
+} MeshData;
+
+/* Identifies the OBJ file a cache entry was built from */
+typedef struct
+{
+    uint64_t mtime;
+    uint64_t size;
+    uint64_t hash;
+} MeshSourceInfo;
+
+/* On-disk layout: this header followed by 16 byte aligned streams */
+typedef struct
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+
+    MeshSourceInfo source;
+    float scale;
+    float weldEpsilon;
+    uint32_t optimized;
+    uint32_t simplified;
+
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t indexSize;     // bytes per index, 2 or 4
+    uint32_t vertexFormat;  // MeshVertexFormat
+    uint32_t vertexStride;
+
+    float boundsMin[3];
+    float boundsMax[3];
+    float positionScale[3];
+    float positionBias[3];
+
+    uint32_t lodCount;
+    MeshLod lods[MESH_MAX_LODS];
+
+    uint64_t vertexOffset;
+    uint64_t indexOffset;
+} MeshBinHeader;
+
+/* Read-only streams of one mesh, pointing either into a MeshData
+ * or straight into a mapped cache file */
+typedef struct
+{
+    const void *vertices;
+    const void *indices;
+
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    uint32_t indexSize;
+    uint32_t vertexFormat;
+    uint32_t vertexStride;
+
+    float boundsMin[3];
+    float boundsMax[3];
+    float positionScale[3];
+    float positionBias[3];
+    float scale;
+    float weldEpsilon;
+    int optimized;
+    int simplified;
+
+    uint32_t lodCount;
+    MeshLod lods[MESH_MAX_LODS];
+
+    mapped_file file;   // data is null unless the view is backed by a cache file
+} MeshView;
+
+int BuildMeshData(const obj_scene_data *data, float scale, const MeshImportOptions *options, MeshData *mesh);
+
+void GenerateMeshLods(MeshData *mesh);
+
+void OptimizeMeshData(MeshData *mesh);
+
+void PackMeshIndices(MeshData *mesh);
+
+void PackMeshVertices(MeshData *mesh, int quantize);
+
+void GetMeshView(const MeshData *mesh, MeshView *view);
+
+void CloseMeshView(MeshView *view);
+
+int GetMeshSourceInfo(const char *objPath, int withHash, MeshSourceInfo *info);
+
+int WriteMeshBin(const char *path, const MeshData *mesh, const MeshSourceInfo *source);
+
+int OpenMeshBin(const char *path, MeshView *view, MeshBinHeader *header);
+
+std::string MeshCachePath(const std::string &objPath, float scale, const MeshImportOptions *options);
+
+int ConvertObjToMeshBin(const char *objPath, float scale, const MeshImportOptions *options, const char *outPath);
+
+int LoadMesh(const std::string &objPath, float scale, const MeshImportOptions *options, MeshData *storage,
+             MeshView *view, int parseThreads = 0);
+
+#endif
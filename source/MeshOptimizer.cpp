@@ -0,0 +1,311 @@
+/******************************************************************
+*
+* MeshOptimizer.cpp
+*
+* Description: Triangle and vertex reordering for indexed meshes:
+* post-transform vertex cache optimization (Tipsify, Sander et al.
+* 2007), overdraw-aware ordering of the resulting clusters and
+* vertex fetch reordering, plus the ACMR/ATVR cache statistics.
+*
+*******************************************************************/
+
+#include <algorithm>
+#include <cmath>
+
+#include "MeshOptimizer.hpp"
+
+/* Triangles around every vertex, in compressed row form */
+typedef struct
+{
+    std::vector<uint32_t> offsets;   // vertexCount + 1 entries
+    std::vector<uint32_t> triangles;
+} VertexAdjacency;
+
+static void BuildAdjacency(const std::vector<uint32_t> &indices, uint32_t vertexCount, VertexAdjacency *adjacency)
+{
+    adjacency->offsets.assign(vertexCount + 1, 0);
+    for (uint32_t index : indices)
+        adjacency->offsets[index + 1]++;
+    for (uint32_t v = 0; v < vertexCount; v++)
+        adjacency->offsets[v + 1] += adjacency->offsets[v];
+
+    std::vector<uint32_t> fill(adjacency->offsets.begin(), adjacency->offsets.end() - 1);
+    adjacency->triangles.resize(indices.size());
+    for (size_t i = 0; i < indices.size(); i++)
+        adjacency->triangles[fill[indices[i]]++] = i / 3;
+}
+
+/******************************************************************
+*
+* @brief Reorders triangles for a post-transform vertex cache of
+* 'cacheSize' entries. Triangles are emitted as fans around a
+* vertex; the next fan vertex is picked from the last fan's vertices
+* so that it is still in the cache. When none is left the search
+* jumps elsewhere in the mesh, which starts a new cluster.
+*
+* @param indices = triangle list, reordered in place
+* @param vertexCount = number of vertices referenced by the indices
+* @param cacheSize = simulated cache size
+* @return triangle offsets at which clusters start (first one is 0)
+*******************************************************************/
+std::vector<uint32_t> OptimizeVertexCache(std::vector<uint32_t> *indices, uint32_t vertexCount, int cacheSize)
+{
+    size_t triangleCount = indices->size() / 3;
+    std::vector<uint32_t> clusters;
+
+    if (triangleCount == 0)
+        return clusters;
+
+    VertexAdjacency adjacency;
+    BuildAdjacency(*indices, vertexCount, &adjacency);
+
+    std::vector<uint32_t> live(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; v++)
+        live[v] = adjacency.offsets[v + 1] - adjacency.offsets[v];
+
+    std::vector<int> cacheTime(vertexCount, 0);
+    std::vector<char> emitted(triangleCount, 0);
+    std::vector<uint32_t> deadEnd;
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> result;
+    result.reserve(indices->size());
+
+    int timestamp = cacheSize + 1;
+    uint32_t cursor = 0;
+    long fanning = (*indices)[0];
+
+    clusters.push_back(0);
+
+    while (fanning >= 0)
+    {
+        candidates.clear();
+
+        /* emit every remaining triangle around the fanning vertex */
+        for (uint32_t a = adjacency.offsets[fanning]; a < adjacency.offsets[fanning + 1]; a++)
+        {
+            uint32_t t = adjacency.triangles[a];
+            if (emitted[t])
+                continue;
+
+            for (int k = 0; k < 3; k++)
+            {
+                uint32_t v = (*indices)[t * 3 + k];
+                result.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                live[v]--;
+
+                if (timestamp - cacheTime[v] > cacheSize)
+                    cacheTime[v] = timestamp++;
+            }
+            emitted[t] = 1;
+        }
+
+        /* prefer the candidate that stays in the cache for its remaining fan */
+        long next = -1;
+        int best = -1;
+        for (uint32_t v : candidates)
+        {
+            if (live[v] == 0)
+                continue;
+
+            int priority = 0;
+            if (timestamp - cacheTime[v] + 2 * (int) live[v] <= cacheSize)
+                priority = timestamp - cacheTime[v];
+
+            if (priority > best)
+            {
+                best = priority;
+                next = v;
+            }
+        }
+
+        if (next < 0)
+        {
+            /* dead end: recently used vertices first, then scan the mesh */
+            while (!deadEnd.empty() && next < 0)
+            {
+                uint32_t d = deadEnd.back();
+                deadEnd.pop_back();
+                if (live[d] > 0)
+                    next = d;
+            }
+            while (next < 0 && cursor < vertexCount)
+            {
+                if (live[cursor] > 0)
+                    next = cursor;
+                cursor++;
+            }
+
+            if (next >= 0 && result.size() / 3 != clusters.back())
+                clusters.push_back(result.size() / 3);
+        }
+
+        fanning = next;
+    }
+
+    indices->swap(result);
+    return clusters;
+}
+
+/******************************************************************
+*
+* @brief Orders the clusters from OptimizeVertexCache by how much
+* they face away from the mesh center (Sander et al. 2007): outward
+* facing clusters are drawn first and occlude the rest, while the
+* triangle order inside every cluster is kept for the vertex cache.
+*
+*******************************************************************/
+void OptimizeOverdraw(std::vector<uint32_t> *indices, const std::vector<uint32_t> &clusters,
+                      const float *positions, uint32_t vertexCount)
+{
+    size_t triangleCount = indices->size() / 3;
+    if (clusters.size() < 2 || vertexCount == 0)
+        return;
+
+    /* area weighted centroid of the whole mesh and of every cluster */
+    std::vector<float> clusterCentroid(clusters.size() * 3, 0.0f);
+    std::vector<float> clusterNormal(clusters.size() * 3, 0.0f);
+    std::vector<float> clusterArea(clusters.size(), 0.0f);
+    float meshCentroid[3] = {0, 0, 0};
+    float meshArea = 0;
+
+    for (size_t c = 0; c < clusters.size(); c++)
+    {
+        size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+        for (size_t t = clusters[c]; t < end; t++)
+        {
+            const float *p0 = positions + (*indices)[t * 3] * 3;
+            const float *p1 = positions + (*indices)[t * 3 + 1] * 3;
+            const float *p2 = positions + (*indices)[t * 3 + 2] * 3;
+
+            float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+            float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+            float n[3] = {e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0]};
+            float area = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+            for (int k = 0; k < 3; k++)
+            {
+                float center = (p0[k] + p1[k] + p2[k]) / 3.0f;
+                clusterCentroid[c * 3 + k] += center * area;
+                clusterNormal[c * 3 + k] += n[k];
+                meshCentroid[k] += center * area;
+            }
+            clusterArea[c] += area;
+            meshArea += area;
+        }
+    }
+
+    if (meshArea > 0)
+        for (int k = 0; k < 3; k++)
+            meshCentroid[k] /= meshArea;
+
+    std::vector<float> key(clusters.size(), 0.0f);
+    for (size_t c = 0; c < clusters.size(); c++)
+    {
+        if (clusterArea[c] <= 0)
+            continue;
+
+        float *n = &clusterNormal[c * 3];
+        float length = sqrtf(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+        if (length <= 0)
+            continue;
+
+        for (int k = 0; k < 3; k++)
+            key[c] += (clusterCentroid[c * 3 + k] / clusterArea[c] - meshCentroid[k]) * n[k] / length;
+    }
+
+    std::vector<uint32_t> order(clusters.size());
+    for (size_t c = 0; c < order.size(); c++)
+        order[c] = c;
+    std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return key[a] > key[b]; });
+
+    std::vector<uint32_t> result;
+    result.reserve(indices->size());
+    for (uint32_t c : order)
+    {
+        size_t end = c + 1 < clusters.size() ? clusters[c + 1] : triangleCount;
+        result.insert(result.end(), indices->begin() + clusters[c] * 3, indices->begin() + end * 3);
+    }
+
+    indices->swap(result);
+}
+
+/******************************************************************
+*
+* @brief Renumbers vertices in the order the index buffer first
+* references them, so vertex fetches walk memory front to back.
+* Unreferenced vertices are moved to the end.
+*
+*******************************************************************/
+std::vector<uint32_t> OptimizeVertexFetch(std::vector<uint32_t> *indices, uint32_t vertexCount)
+{
+    const uint32_t unused = ~0u;
+    std::vector<uint32_t> remap(vertexCount, unused);
+    uint32_t next = 0;
+
+    for (uint32_t &index : *indices)
+    {
+        if (remap[index] == unused)
+            remap[index] = next++;
+        index = remap[index];
+    }
+
+    for (uint32_t &r : remap)
+        if (r == unused)
+            r = next++;
+
+    return remap;
+}
+
+void RemapVertexStream(std::vector<float> *stream, const std::vector<uint32_t> &remap, int components)
+{
+    std::vector<float> result(stream->size());
+
+    for (size_t v = 0; v < remap.size(); v++)
+        for (int k = 0; k < components; k++)
+            result[remap[v] * components + k] = (*stream)[v * components + k];
+
+    stream->swap(result);
+}
+
+/******************************************************************
+*
+* @brief Counts the vertex shader invocations of an index buffer with
+* a FIFO post-transform cache
+*
+* @return ACMR (invocations per triangle) and ATVR (invocations per
+* referenced vertex)
+*******************************************************************/
+VertexCacheStats AnalyzeVertexCache(const uint32_t *indices, size_t indexCount, uint32_t vertexCount,
+                                    int cacheSize)
+{
+    VertexCacheStats stats = {0.0f, 0.0f};
+    std::vector<long> cacheTime(vertexCount, -1);
+    std::vector<char> used(vertexCount, 0);
+    long timestamp = 0;
+    size_t misses = 0;
+    size_t usedCount = 0;
+
+    for (size_t i = 0; i < indexCount; i++)
+    {
+        uint32_t v = indices[i];
+        if (cacheTime[v] < 0 || timestamp - cacheTime[v] >= cacheSize)
+        {
+            cacheTime[v] = timestamp++;
+            misses++;
+        }
+        if (!used[v])
+        {
+            used[v] = 1;
+            usedCount++;
+        }
+    }
+
+    if (indexCount > 0)
+        stats.acmr = (float) misses / (indexCount / 3);
+    if (usedCount > 0)
+        stats.atvr = (float) misses / usedCount;
+
+    return stats;
+}
@@ -0,0 +1,46 @@
+/******************************************************************
+*
+* MeshOptimizer.hpp
+*
+* Description: Triangle and vertex reordering for indexed meshes:
+* post-transform vertex cache optimization (Tipsify, Sander et al.
+* 2007), overdraw-aware ordering of the resulting clusters and
+* vertex fetch reordering, plus the ACMR/ATVR cache statistics.
+*
+*******************************************************************/
+
+#ifndef MESH_OPTIMIZER_H
+#define MESH_OPTIMIZER_H
+
+#include <cstdint>
+#include <vector>
+
+/* Size of the simulated post-transform vertex cache */
+#define MESH_OPTIMIZER_CACHE_SIZE 16
+
+/* Post-transform cache efficiency of an index buffer */
+typedef struct
+{
+    float acmr; // transformed vertices per triangle (0.5 .. 3, lower is better)
+    float atvr; // transformed vertices per vertex (1 is optimal)
+} VertexCacheStats;
+
+/* Reorders the triangles for the vertex cache and returns the offsets
+ * (in triangles) where a new cluster of connected triangles starts */
+std::vector<uint32_t> OptimizeVertexCache(std::vector<uint32_t> *indices, uint32_t vertexCount, int cacheSize);
+
+/* Sorts the clusters so that triangles likely to occlude others come first */
+void OptimizeOverdraw(std::vector<uint32_t> *indices, const std::vector<uint32_t> &clusters,
+                      const float *positions, uint32_t vertexCount);
+
+/* Renumbers vertices in order of first use; returns the new index of every old vertex */
+std::vector<uint32_t> OptimizeVertexFetch(std::vector<uint32_t> *indices, uint32_t vertexCount);
+
+/* Applies a remap from OptimizeVertexFetch to an attribute stream with 'components' floats per vertex */
+void RemapVertexStream(std::vector<float> *stream, const std::vector<uint32_t> &remap, int components);
+
+/* Simulates a FIFO post-transform cache of 'cacheSize' entries */
+VertexCacheStats AnalyzeVertexCache(const uint32_t *indices, size_t indexCount, uint32_t vertexCount,
+                                    int cacheSize);
+
+#endif
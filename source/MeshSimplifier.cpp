@@ -0,0 +1,294 @@
+/******************************************************************
+*
+* MeshSimplifier.cpp
+*
+* Description: Quadric error metric simplification (Garland and
+* Heckbert 1997) of indexed triangle meshes. Edges are collapsed onto
+* one of their vertices, so every level of detail keeps using the
+* vertex buffer of the full mesh.
+*
+*******************************************************************/
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "MeshSimplifier.hpp"
+
+/* Symmetric 4x4 matrix: area weighted sum of squared distances to a
+ * set of planes, and the total weight */
+typedef struct
+{
+    double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+    double weight;
+} Quadric;
+
+typedef struct
+{
+    uint32_t from;
+    uint32_t to;
+    double cost;
+} Collapse;
+
+static void AddPlane(Quadric *q, double a, double b, double c, double d, double weight)
+{
+    q->a2 += weight * a * a; q->ab += weight * a * b; q->ac += weight * a * c; q->ad += weight * a * d;
+    q->b2 += weight * b * b; q->bc += weight * b * c; q->bd += weight * b * d;
+    q->c2 += weight * c * c; q->cd += weight * c * d;
+    q->d2 += weight * d * d;
+    q->weight += weight;
+}
+
+static void AddQuadric(Quadric *q, const Quadric &other)
+{
+    q->a2 += other.a2; q->ab += other.ab; q->ac += other.ac; q->ad += other.ad;
+    q->b2 += other.b2; q->bc += other.bc; q->bd += other.bd;
+    q->c2 += other.c2; q->cd += other.cd;
+    q->d2 += other.d2;
+    q->weight += other.weight;
+}
+
+/* Mean squared distance of p to the planes of a quadric */
+static double QuadricError(const Quadric &q, const float *p)
+{
+    double x = p[0], y = p[1], z = p[2];
+    double error = q.a2 * x * x + 2 * q.ab * x * y + 2 * q.ac * x * z + 2 * q.ad * x +
+                   q.b2 * y * y + 2 * q.bc * y * z + 2 * q.bd * y +
+                   q.c2 * z * z + 2 * q.cd * z + q.d2;
+    return error > 0 && q.weight > 0 ? error / q.weight : 0;
+}
+
+static void TriangleNormal(const float *p0, const float *p1, const float *p2, float *n)
+{
+    float e1[3] = {p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2]};
+    float e2[3] = {p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2]};
+    n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+    n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+    n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+}
+
+/******************************************************************
+*
+* @brief Marks the vertices that must not move: vertices that share
+* their position with another vertex (uv or normal seams) and
+* vertices on border or non-manifold edges of the position topology
+*
+*******************************************************************/
+static void FindLockedVertices(const std::vector<uint32_t> &indices, const float *positions, uint32_t vertexCount,
+                               std::vector<char> *locked)
+{
+    /* group vertices with identical positions */
+    std::vector<uint32_t> order(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; v++)
+        order[v] = v;
+    std::sort(order.begin(), order.end(), [positions](uint32_t a, uint32_t b) {
+        return memcmp(positions + a * 3, positions + b * 3, 3 * sizeof(float)) < 0;
+    });
+
+    std::vector<uint32_t> positionClass(vertexCount);
+    std::vector<uint32_t> classSize;
+    for (uint32_t i = 0; i < vertexCount; i++)
+    {
+        if (i == 0 || memcmp(positions + order[i] * 3, positions + order[i - 1] * 3, 3 * sizeof(float)) != 0)
+            classSize.push_back(0);
+        positionClass[order[i]] = classSize.size() - 1;
+        classSize.back()++;
+    }
+
+    /* edges used by exactly two triangles are interior edges */
+    std::vector<uint64_t> edges;
+    edges.reserve(indices.size());
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        for (int k = 0; k < 3; k++)
+        {
+            uint64_t a = positionClass[indices[i + k]];
+            uint64_t b = positionClass[indices[i + (k + 1) % 3]];
+            edges.push_back(a < b ? (a << 32) | b : (b << 32) | a);
+        }
+    }
+    std::sort(edges.begin(), edges.end());
+
+    std::vector<char> lockedClass(classSize.size(), 0);
+    for (size_t i = 0; i < edges.size();)
+    {
+        size_t run = i;
+        while (run < edges.size() && edges[run] == edges[i])
+            run++;
+        if (run - i != 2)
+        {
+            lockedClass[edges[i] >> 32] = 1;
+            lockedClass[edges[i] & 0xffffffff] = 1;
+        }
+        i = run;
+    }
+
+    locked->resize(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; v++)
+        (*locked)[v] = classSize[positionClass[v]] > 1 || lockedClass[positionClass[v]];
+}
+
+/* Rejects a collapse of 'from' onto 'to' that would flip one of the triangles around 'from' */
+static int CollapseFlips(const std::vector<uint32_t> &indices, const uint32_t *triangles, uint32_t triangleCount,
+                         const float *positions, uint32_t from, uint32_t to)
+{
+    for (uint32_t i = 0; i < triangleCount; i++)
+    {
+        const uint32_t *tri = &indices[triangles[i] * 3];
+        if (tri[0] == to || tri[1] == to || tri[2] == to)
+            continue;   // removed by the collapse
+
+        const float *p[3];
+        const float *moved[3];
+        for (int k = 0; k < 3; k++)
+        {
+            p[k] = positions + tri[k] * 3;
+            moved[k] = tri[k] == from ? positions + to * 3 : p[k];
+        }
+
+        float before[3], after[3];
+        TriangleNormal(p[0], p[1], p[2], before);
+        TriangleNormal(moved[0], moved[1], moved[2], after);
+        if (before[0] * after[0] + before[1] * after[1] + before[2] * after[2] <= 0)
+            return 1;
+    }
+    return 0;
+}
+
+/******************************************************************
+*
+* @brief Collapses edges in passes: every pass sorts all possible
+* collapses by their quadric error and applies the cheapest ones
+* whose neighborhoods do not overlap, until the next target is
+* reached. The index list is saved whenever a target is passed, so
+* the levels form one chain of increasing error.
+*
+*******************************************************************/
+void SimplifyMeshLods(const std::vector<uint32_t> &indices, const float *positions, uint32_t vertexCount,
+                      const float *ratios, int count, std::vector<uint32_t> *lods, float *errors)
+{
+    std::vector<char> locked;
+    FindLockedVertices(indices, positions, vertexCount, &locked);
+
+    std::vector<Quadric> quadrics(vertexCount);
+    memset(quadrics.data(), 0, quadrics.size() * sizeof(Quadric));
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        float n[3];
+        const float *p0 = positions + indices[i] * 3;
+        TriangleNormal(p0, positions + indices[i + 1] * 3, positions + indices[i + 2] * 3, n);
+
+        double length = sqrt((double) n[0] * n[0] + (double) n[1] * n[1] + (double) n[2] * n[2]);
+        if (length <= 0)
+            continue;
+
+        double a = n[0] / length, b = n[1] / length, c = n[2] / length;
+        double d = -(a * p0[0] + b * p0[1] + c * p0[2]);
+        for (int k = 0; k < 3; k++)
+            AddPlane(&quadrics[indices[i + k]], a, b, c, d, length * 0.5);
+    }
+
+    std::vector<uint32_t> current = indices;
+    std::vector<uint32_t> offsets, triangles;
+    std::vector<uint32_t> collapseTo(vertexCount);
+    std::vector<char> touched(vertexCount);
+    std::vector<Collapse> candidates;
+    double maxError = 0;
+
+    for (int level = 0; level < count; level++)
+    {
+        size_t target = (size_t) (indices.size() / 3 * ratios[level]) * 3;
+
+        while (current.size() > target)
+        {
+            /* triangles around every vertex */
+            offsets.assign(vertexCount + 1, 0);
+            for (uint32_t index : current)
+                offsets[index + 1]++;
+            for (uint32_t v = 0; v < vertexCount; v++)
+                offsets[v + 1] += offsets[v];
+            std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+            triangles.resize(current.size());
+            for (size_t i = 0; i < current.size(); i++)
+                triangles[fill[current[i]]++] = i / 3;
+
+            candidates.clear();
+            for (size_t i = 0; i < current.size(); i += 3)
+            {
+                for (int k = 0; k < 3; k++)
+                {
+                    uint32_t a = current[i + k];
+                    uint32_t b = current[i + (k + 1) % 3];
+                    Quadric q = quadrics[a];
+                    AddQuadric(&q, quadrics[b]);
+
+                    if (!locked[a])
+                        candidates.push_back({a, b, QuadricError(q, positions + b * 3)});
+                    if (!locked[b])
+                        candidates.push_back({b, a, QuadricError(q, positions + a * 3)});
+                }
+            }
+            std::sort(candidates.begin(), candidates.end(),
+                      [](const Collapse &x, const Collapse &y) { return x.cost < y.cost; });
+
+            for (uint32_t v = 0; v < vertexCount; v++)
+                collapseTo[v] = v;
+            std::fill(touched.begin(), touched.end(), 0);
+
+            size_t removed = 0;
+            size_t excess = (current.size() - target) / 3;
+            for (const Collapse &collapse : candidates)
+            {
+                if (removed >= excess)
+                    break;
+
+                uint32_t from = collapse.from, to = collapse.to;
+                if (touched[from] || touched[to])
+                    continue;
+
+                /* the flip test needs the final positions of all neighbors */
+                const uint32_t *around = &triangles[offsets[from]];
+                uint32_t aroundCount = offsets[from + 1] - offsets[from];
+                int moved = 0;
+                size_t shared = 0;
+                for (uint32_t i = 0; i < aroundCount; i++)
+                {
+                    const uint32_t *tri = &current[around[i] * 3];
+                    for (int k = 0; k < 3; k++)
+                        moved |= collapseTo[tri[k]] != tri[k];
+                    shared += tri[0] == to || tri[1] == to || tri[2] == to;
+                }
+                if (moved || CollapseFlips(current, around, aroundCount, positions, from, to))
+                    continue;
+
+                collapseTo[from] = to;
+                touched[from] = touched[to] = 1;
+                AddQuadric(&quadrics[to], quadrics[from]);
+                if (collapse.cost > maxError)
+                    maxError = collapse.cost;
+                removed += shared;
+            }
+
+            if (removed == 0)
+                break;
+
+            /* apply the collapses and drop the triangles that became degenerate */
+            size_t write = 0;
+            for (size_t i = 0; i < current.size(); i += 3)
+            {
+                uint32_t a = collapseTo[current[i]];
+                uint32_t b = collapseTo[current[i + 1]];
+                uint32_t c = collapseTo[current[i + 2]];
+                if (a == b || b == c || c == a)
+                    continue;
+                current[write++] = a;
+                current[write++] = b;
+                current[write++] = c;
+            }
+            current.resize(write);
+        }
+
+        lods[level] = current;
+        errors[level] = (float) sqrt(maxError);
+    }
+}
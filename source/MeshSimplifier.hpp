@@ -0,0 +1,27 @@
+/******************************************************************
+*
+* MeshSimplifier.hpp
+*
+* Description: Quadric error metric simplification (Garland and
+* Heckbert 1997) of indexed triangle meshes. Edges are collapsed onto
+* one of their vertices, so every level of detail keeps using the
+* vertex buffer of the full mesh.
+*
+*******************************************************************/
+
+#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+
+#include <cstdint>
+#include <vector>
+
+/* Simplifies a triangle list to each of 'count' triangle ratios (descending,
+ * e.g. 0.5, 0.25, 0.1). lods[i] receives the indices of level i and errors[i]
+ * how far its collapses moved the surface (the largest RMS distance of a
+ * collapsed vertex to the planes of the triangles it replaced). Vertices on
+ * borders and on attribute seams are kept in place, so a level may end above
+ * its target when nothing else can be collapsed. */
+void SimplifyMeshLods(const std::vector<uint32_t> &indices, const float *positions, uint32_t vertexCount,
+                      const float *ratios, int count, std::vector<uint32_t> *lods, float *errors);
+
+#endif
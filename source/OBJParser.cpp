@@ -21,11 +21,48 @@
 #include <cstring>
 #include <cstdlib>
 #include <iostream>
+#include <charconv>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "OBJParser.hpp"
+#include "MappedFile.hpp"
+
+#include <sys/stat.h>
 
 #define WHITESPACE " \t\n\r"
+#define OBJ_PARALLEL_MIN_SIZE (4 * 1024 * 1024)
+
+
+/* strtok() keeps its position in one global; files are parsed on several
+ * threads at once (asset loader), so every thread tokenizes on its own */
+static char *obj_strtok(char *str, const char *delim)
+{
+    static thread_local char *next = NULL;
+
+    if (str != NULL)
+        next = str;
+    if (next == NULL)
+        return NULL;
+
+    next += strspn(next, delim);
+    if (*next == '\0')
+    {
+        next = NULL;
+        return NULL;
+    }
 
+    char *token = next;
+    next += strcspn(next, delim);
+    if (*next != '\0')
+        *next++ = '\0';
+    else
+        next = NULL;
+    return token;
+}
 
 void obj_free_half_list(list *listo)
 {
@@ -33,6 +70,34 @@ void obj_free_half_list(list *listo)
     free(listo->names);
 }
 
+static inline int obj_vertex_count(const obj_growable_scene_data *scene)
+{
+    return scene->vertex_positions.size() / 3;
+}
+
+static inline int obj_normal_count(const obj_growable_scene_data *scene)
+{
+    return scene->vertex_normals.size() / 3;
+}
+
+static inline int obj_texture_count(const obj_growable_scene_data *scene)
+{
+    return scene->vertex_uvs.size() / 2;
+}
+
+/* Appends one face to the structure-of-arrays storage */
+static void obj_add_face(obj_growable_scene_data *scene, const obj_face *face)
+{
+    scene->face_vertex_index.insert(scene->face_vertex_index.end(), face->vertex_index,
+                                    face->vertex_index + MAX_VERTEX_COUNT);
+    scene->face_normal_index.insert(scene->face_normal_index.end(), face->normal_index,
+                                    face->normal_index + MAX_VERTEX_COUNT);
+    scene->face_texture_index.insert(scene->face_texture_index.end(), face->texture_index,
+                                     face->texture_index + MAX_VERTEX_COUNT);
+    scene->face_vertex_count.push_back(face->vertex_count);
+    scene->face_material_index.push_back(face->material_index);
+}
+
 int obj_convert_to_list_index(int current_max, int index)
 {
     if (index == 0)  //no index
@@ -77,7 +142,7 @@ int obj_parse_vertex_index(int *vertex_index, int *texture_index, int *normal_in
     int vertex_count = 0;
 
 
-    while ((token = strtok(NULL, WHITESPACE)) != NULL)
+    while (vertex_count < MAX_VERTEX_COUNT && (token = obj_strtok(NULL, WHITESPACE)) != NULL)
     {
         if (texture_index != NULL)
             texture_index[vertex_count] = 0;
@@ -109,17 +174,17 @@ int obj_parse_vertex_index(int *vertex_index, int *texture_index, int *normal_in
     return vertex_count;
 }
 
-obj_face *obj_parse_face(obj_growable_scene_data *scene)
+void obj_parse_face(obj_growable_scene_data *scene, int material_index)
 {
-    int vertex_count;
-    obj_face *face = (obj_face *) malloc(sizeof(obj_face));
-
-    vertex_count = obj_parse_vertex_index(face->vertex_index, face->texture_index, face->normal_index);
-    obj_convert_to_list_index_v(scene->vertex_list.item_count, face->vertex_index);
-    obj_convert_to_list_index_v(scene->vertex_texture_list.item_count, face->texture_index);
-    obj_convert_to_list_index_v(scene->vertex_normal_list.item_count, face->normal_index);
-    face->vertex_count = vertex_count;
-    return face;
+    obj_face face;
+    memset(&face, 0, sizeof(face));
+
+    face.vertex_count = obj_parse_vertex_index(face.vertex_index, face.texture_index, face.normal_index);
+    obj_convert_to_list_index_v(obj_vertex_count(scene), face.vertex_index);
+    obj_convert_to_list_index_v(obj_texture_count(scene), face.texture_index);
+    obj_convert_to_list_index_v(obj_normal_count(scene), face.normal_index);
+    face.material_index = material_index;
+    obj_add_face(scene, &face);
 }
 
 obj_sphere *obj_parse_sphere(obj_growable_scene_data *scene)
@@ -128,10 +193,10 @@ obj_sphere *obj_parse_sphere(obj_growable_scene_data *scene)
 
     obj_sphere *obj = (obj_sphere *) malloc(sizeof(obj_sphere));
     obj_parse_vertex_index(temp_indices, obj->texture_index, NULL);
-    obj_convert_to_list_index_v(scene->vertex_texture_list.item_count, obj->texture_index);
-    obj->pos_index = obj_convert_to_list_index(scene->vertex_list.item_count, temp_indices[0]);
-    obj->up_normal_index = obj_convert_to_list_index(scene->vertex_normal_list.item_count, temp_indices[1]);
-    obj->equator_normal_index = obj_convert_to_list_index(scene->vertex_normal_list.item_count, temp_indices[2]);
+    obj_convert_to_list_index_v(obj_texture_count(scene), obj->texture_index);
+    obj->pos_index = obj_convert_to_list_index(obj_vertex_count(scene), temp_indices[0]);
+    obj->up_normal_index = obj_convert_to_list_index(obj_normal_count(scene), temp_indices[1]);
+    obj->equator_normal_index = obj_convert_to_list_index(obj_normal_count(scene), temp_indices[2]);
 
     return obj;
 }
@@ -142,10 +207,10 @@ obj_plane *obj_parse_plane(obj_growable_scene_data *scene)
 
     obj_plane *obj = (obj_plane *) malloc(sizeof(obj_plane));
     obj_parse_vertex_index(temp_indices, obj->texture_index, NULL);
-    obj_convert_to_list_index_v(scene->vertex_texture_list.item_count, obj->texture_index);
-    obj->pos_index = obj_convert_to_list_index(scene->vertex_list.item_count, temp_indices[0]);
-    obj->normal_index = obj_convert_to_list_index(scene->vertex_normal_list.item_count, temp_indices[1]);
-    obj->rotation_normal_index = obj_convert_to_list_index(scene->vertex_normal_list.item_count, temp_indices[2]);
+    obj_convert_to_list_index_v(obj_texture_count(scene), obj->texture_index);
+    obj->pos_index = obj_convert_to_list_index(obj_vertex_count(scene), temp_indices[0]);
+    obj->normal_index = obj_convert_to_list_index(obj_normal_count(scene), temp_indices[1]);
+    obj->rotation_normal_index = obj_convert_to_list_index(obj_normal_count(scene), temp_indices[2]);
 
     return obj;
 }
@@ -153,7 +218,7 @@ obj_plane *obj_parse_plane(obj_growable_scene_data *scene)
 obj_light_point *obj_parse_light_point(obj_growable_scene_data *scene)
 {
     obj_light_point *o = (obj_light_point *) malloc(sizeof(obj_light_point));
-    o->pos_index = obj_convert_to_list_index(scene->vertex_list.item_count, atoi(strtok(NULL, WHITESPACE)));
+    o->pos_index = obj_convert_to_list_index(obj_vertex_count(scene), atoi(obj_strtok(NULL, WHITESPACE)));
     return o;
 }
 
@@ -161,7 +226,7 @@ obj_light_quad *obj_parse_light_quad(obj_growable_scene_data *scene)
 {
     obj_light_quad *o = (obj_light_quad *) malloc(sizeof(obj_light_quad));
     obj_parse_vertex_index(o->vertex_index, NULL, NULL);
-    obj_convert_to_list_index_v(scene->vertex_list.item_count, o->vertex_index);
+    obj_convert_to_list_index_v(obj_vertex_count(scene), o->vertex_index);
 
     return o;
 }
@@ -172,39 +237,33 @@ obj_light_disc *obj_parse_light_disc(obj_growable_scene_data *scene)
 
     obj_light_disc *obj = (obj_light_disc *) malloc(sizeof(obj_light_disc));
     obj_parse_vertex_index(temp_indices, NULL, NULL);
-    obj->pos_index = obj_convert_to_list_index(scene->vertex_list.item_count, temp_indices[0]);
-    obj->normal_index = obj_convert_to_list_index(scene->vertex_normal_list.item_count, temp_indices[1]);
+    obj->pos_index = obj_convert_to_list_index(obj_vertex_count(scene), temp_indices[0]);
+    obj->normal_index = obj_convert_to_list_index(obj_normal_count(scene), temp_indices[1]);
 
     return obj;
 }
 
-obj_vector *obj_parse_vector()
+void obj_parse_vector(std::vector<float> *out)
 {
-
-    obj_vector *v = (obj_vector *) malloc(sizeof(obj_vector));
-    v->e[0] = atof(strtok(NULL, WHITESPACE));
-    v->e[1] = atof(strtok(NULL, WHITESPACE));
-    v->e[2] = atof(strtok(NULL, WHITESPACE));
-    return v;
+    out->push_back(atof(obj_strtok(NULL, WHITESPACE)));
+    out->push_back(atof(obj_strtok(NULL, WHITESPACE)));
+    out->push_back(atof(obj_strtok(NULL, WHITESPACE)));
 }
 
 
-obj_vector2 *obj_parse_vector2()
+void obj_parse_vector2(std::vector<float> *out)
 {
-
-    obj_vector2 *v = (obj_vector2 *) malloc(sizeof(obj_vector2));
-    v->e[0] = atof(strtok(NULL, WHITESPACE));
-    v->e[1] = atof(strtok(NULL, WHITESPACE));
-    return v;
+    out->push_back(atof(obj_strtok(NULL, WHITESPACE)));
+    out->push_back(atof(obj_strtok(NULL, WHITESPACE)));
 }
 
 void obj_parse_camera(obj_growable_scene_data *scene, obj_camera *camera)
 {
     int indices[3];
     obj_parse_vertex_index(indices, NULL, NULL);
-    camera->camera_pos_index = obj_convert_to_list_index(scene->vertex_list.item_count, indices[0]);
-    camera->camera_look_point_index = obj_convert_to_list_index(scene->vertex_list.item_count, indices[1]);
-    camera->camera_up_norm_index = obj_convert_to_list_index(scene->vertex_normal_list.item_count, indices[2]);
+    camera->camera_pos_index = obj_convert_to_list_index(obj_vertex_count(scene), indices[0]);
+    camera->camera_look_point_index = obj_convert_to_list_index(obj_vertex_count(scene), indices[1]);
+    camera->camera_up_norm_index = obj_convert_to_list_index(obj_normal_count(scene), indices[2]);
 }
 
 int obj_parse_mtl_file(char *filename, list *material_list)
@@ -230,7 +289,7 @@ int obj_parse_mtl_file(char *filename, list *material_list)
 
     while (fgets(current_line, OBJ_LINE_SIZE, mtl_file_stream))
     {
-        current_token = strtok(current_line, " \t\n\r");
+        current_token = obj_strtok(current_line, " \t\n\r");
         line_number++;
 
         //skip comments
@@ -246,57 +305,57 @@ int obj_parse_mtl_file(char *filename, list *material_list)
             obj_set_material_defaults(current_mtl);
 
             // get the name
-            strncpy(current_mtl->name, strtok(NULL, " \t"), MATERIAL_NAME_SIZE);
+            strncpy(current_mtl->name, obj_strtok(NULL, " \t"), MATERIAL_NAME_SIZE);
             list_add_item(material_list, current_mtl, current_mtl->name);
         }
 
             //ambient
         else if (strequal(current_token, "Ka") && material_open)
         {
-            current_mtl->amb[0] = atof(strtok(NULL, " \t"));
-            current_mtl->amb[1] = atof(strtok(NULL, " \t"));
-            current_mtl->amb[2] = atof(strtok(NULL, " \t"));
+            current_mtl->amb[0] = atof(obj_strtok(NULL, " \t"));
+            current_mtl->amb[1] = atof(obj_strtok(NULL, " \t"));
+            current_mtl->amb[2] = atof(obj_strtok(NULL, " \t"));
         }
 
             //diff
         else if (strequal(current_token, "Kd") && material_open)
         {
-            current_mtl->diff[0] = atof(strtok(NULL, " \t"));
-            current_mtl->diff[1] = atof(strtok(NULL, " \t"));
-            current_mtl->diff[2] = atof(strtok(NULL, " \t"));
+            current_mtl->diff[0] = atof(obj_strtok(NULL, " \t"));
+            current_mtl->diff[1] = atof(obj_strtok(NULL, " \t"));
+            current_mtl->diff[2] = atof(obj_strtok(NULL, " \t"));
         }
 
             //specular
         else if (strequal(current_token, "Ks") && material_open)
         {
-            current_mtl->spec[0] = atof(strtok(NULL, " \t"));
-            current_mtl->spec[1] = atof(strtok(NULL, " \t"));
-            current_mtl->spec[2] = atof(strtok(NULL, " \t"));
+            current_mtl->spec[0] = atof(obj_strtok(NULL, " \t"));
+            current_mtl->spec[1] = atof(obj_strtok(NULL, " \t"));
+            current_mtl->spec[2] = atof(obj_strtok(NULL, " \t"));
         }
             //shiny
         else if (strequal(current_token, "Ns") && material_open)
         {
-            current_mtl->shiny = atof(strtok(NULL, " \t"));
+            current_mtl->shiny = atof(obj_strtok(NULL, " \t"));
         }
             //transparent
         else if (strequal(current_token, "d") && material_open)
         {
-            current_mtl->trans = atof(strtok(NULL, " \t"));
+            current_mtl->trans = atof(obj_strtok(NULL, " \t"));
         }
             //reflection
         else if (strequal(current_token, "r") && material_open)
         {
-            current_mtl->reflect = atof(strtok(NULL, " \t"));
+            current_mtl->reflect = atof(obj_strtok(NULL, " \t"));
         }
             //glossy
         else if (strequal(current_token, "sharpness") && material_open)
         {
-            current_mtl->glossy = atof(strtok(NULL, " \t"));
+            current_mtl->glossy = atof(obj_strtok(NULL, " \t"));
         }
             //refract index
         else if (strequal(current_token, "Ni") && material_open)
         {
-            current_mtl->refract_index = atof(strtok(NULL, " \t"));
+            current_mtl->refract_index = atof(obj_strtok(NULL, " \t"));
         }
             // illumination type
         else if (strequal(current_token, "illum") && material_open)
@@ -305,7 +364,7 @@ int obj_parse_mtl_file(char *filename, list *material_list)
             // texture map
         else if (strequal(current_token, "map_Ka") && material_open)
         {
-            strncpy(current_mtl->texture_filename, strtok(NULL, " \t"), OBJ_FILENAME_LENGTH);
+            strncpy(current_mtl->texture_filename, obj_strtok(NULL, " \t"), OBJ_FILENAME_LENGTH);
         } else
         {
             fprintf(stderr, "Unknown command '%s' in material file %s at line %i:\n\t%s\n",
@@ -320,6 +379,79 @@ int obj_parse_mtl_file(char *filename, list *material_list)
 
 }
 
+/*
+ * Handles one line that has already been split off by strtok; the
+ * remaining tokens are consumed by the obj_parse_* helpers.
+ */
+void obj_parse_line(obj_growable_scene_data *growable_data, char *current_token, int line_number,
+                    const char *current_line, int *current_material)
+{
+    //parse objects
+    if (strequal(current_token, "v")) //process vertex
+    {
+        obj_parse_vector(&growable_data->vertex_positions);
+    } else if (strequal(current_token, "vn")) //process vertex normal
+    {
+        obj_parse_vector(&growable_data->vertex_normals);
+    } else if (strequal(current_token, "vt")) //process vertex texture
+    {
+        obj_parse_vector2(&growable_data->vertex_uvs);
+    } else if (strequal(current_token, "f")) //process face
+    {
+        obj_parse_face(growable_data, *current_material);
+    } else if (strequal(current_token, "sp")) //process sphere
+    {
+        obj_sphere *sphr = obj_parse_sphere(growable_data);
+        sphr->material_index = *current_material;
+        list_add_item(&growable_data->sphere_list, sphr, nullptr);
+    } else if (strequal(current_token, "pl")) //process plane
+    {
+        obj_plane *pl = obj_parse_plane(growable_data);
+        pl->material_index = *current_material;
+        list_add_item(&growable_data->plane_list, pl, nullptr);
+    } else if (strequal(current_token, "p")) //process point
+    {
+        //make a small sphere to represent the point?
+    } else if (strequal(current_token, "lp")) //light point source
+    {
+        obj_light_point *o = obj_parse_light_point(growable_data);
+        o->material_index = *current_material;
+        list_add_item(&growable_data->light_point_list, o, nullptr);
+    } else if (strequal(current_token, "ld")) //process light disc
+    {
+        obj_light_disc *o = obj_parse_light_disc(growable_data);
+        o->material_index = *current_material;
+        list_add_item(&growable_data->light_disc_list, o, nullptr);
+    } else if (strequal(current_token, "lq")) //process light quad
+    {
+        obj_light_quad *o = obj_parse_light_quad(growable_data);
+        o->material_index = *current_material;
+        list_add_item(&growable_data->light_quad_list, o, nullptr);
+    } else if (strequal(current_token, "c")) //camera
+    {
+        growable_data->camera = (obj_camera *) malloc(sizeof(obj_camera));
+        obj_parse_camera(growable_data, growable_data->camera);
+    } else if (strequal(current_token, "usemtl")) // usemtl
+    {
+        *current_material = list_find(&growable_data->material_list, obj_strtok(NULL, WHITESPACE));
+    } else if (strequal(current_token, "mtllib")) // mtllib
+    {
+        strncpy(growable_data->material_filename, obj_strtok(NULL, WHITESPACE), OBJ_FILENAME_LENGTH);
+        obj_parse_mtl_file(growable_data->material_filename, &growable_data->material_list);
+    } else if (strequal(current_token, "o")) //object name
+    {}
+    else if (strequal(current_token, "s")) //smoothing
+    {}
+    else if (strequal(current_token, "g")) // group
+    {}
+
+    else
+    {
+        printf("Unknown command '%s' in scene code at line %i: \"%s\".\n",
+               current_token, line_number, current_line);
+    }
+}
+
 int obj_parse_obj_file(obj_growable_scene_data *growable_data, const char *filename)
 {
 
@@ -336,110 +468,522 @@ int obj_parse_obj_file(obj_growable_scene_data *growable_data, const char *filen
         return 0;
     }
 
-/*		
-	extreme_dimensions[0].x = INFINITY; extreme_dimensions[0].y = INFINITY; extreme_dimensions[0].z = INFINITY;
-	extreme_dimensions[1].x = -INFINITY; extreme_dimensions[1].y = -INFINITY; extreme_dimensions[1].z = -INFINITY;
-
-			if(v->x < extreme_dimensions[0].x) extreme_dimensions[0].x = v->x;
-			if(v->x > extreme_dimensions[1].x) extreme_dimensions[1].x = v->x;
-			if(v->y < extreme_dimensions[0].y) extreme_dimensions[0].y = v->y;
-			if(v->y > extreme_dimensions[1].y) extreme_dimensions[1].y = v->y;
-			if(v->z < extreme_dimensions[0].z) extreme_dimensions[0].z = v->z;
-			if(v->z > extreme_dimensions[1].z) extreme_dimensions[1].z = v->z;*/
-
-
     //parser loop
     while (fgets(current_line, OBJ_LINE_SIZE, obj_file_stream))
     {
-        current_token = strtok(current_line, " \t\n\r");
+        current_token = obj_strtok(current_line, " \t\n\r");
         line_number++;
 
         //skip comments
         if (current_token == NULL || current_token[0] == '#')
             continue;
 
-            //parse objects
-        else if (strequal(current_token, "v")) //process vertex
+        obj_parse_line(growable_data, current_token, line_number, current_line, &current_material);
+    }
+
+    fclose(obj_file_stream);
+
+    return 1;
+}
+
+/*----------------------------------------------------------------*/
+
+/*
+ * In-place tokenizer for the memory-mapped path. Tokens are never
+ * copied or terminated; numbers are converted with std::from_chars,
+ * which does not consult the C locale like atof/atoi do.
+ */
+
+static inline int obj_is_space(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static inline const char *obj_skip_space(const char *p, const char *end)
+{
+    while (p < end && obj_is_space(*p))
+        p++;
+    return p;
+}
+
+static inline const char *obj_skip_token(const char *p, const char *end)
+{
+    while (p < end && !obj_is_space(*p))
+        p++;
+    return p;
+}
+
+/* Like atof: a malformed or missing number reads as 0 */
+static inline double obj_scan_double(const char **cursor, const char *end)
+{
+    const char *p = obj_skip_space(*cursor, end);
+    double value = 0;
+
+    if (p < end && *p == '+')
+        p++;
+
+    std::from_chars_result res = std::from_chars(p, end, value);
+    if (res.ec != std::errc())
+        value = 0;
+
+    *cursor = obj_skip_token(p, end);
+    return value;
+}
+
+/* Like atoi: reads leading digits only and leaves p on the first other character */
+static inline int obj_scan_int(const char **cursor, const char *end)
+{
+    const char *p = *cursor;
+    int value = 0;
+
+    if (p < end && *p == '+')
+        p++;
+
+    std::from_chars_result res = std::from_chars(p, end, value);
+    if (res.ec == std::errc())
+        p = res.ptr;
+
+    *cursor = p;
+    return value;
+}
+
+static void obj_scan_vector(std::vector<float> *out, const char *p, const char *end)
+{
+    float x = obj_scan_double(&p, end);
+    float y = obj_scan_double(&p, end);
+    float z = obj_scan_double(&p, end);
+    out->insert(out->end(), {x, y, z});
+}
+
+static void obj_scan_vector2(std::vector<float> *out, const char *p, const char *end)
+{
+    float u = obj_scan_double(&p, end);
+    float v = obj_scan_double(&p, end);
+    out->insert(out->end(), {u, v});
+}
+
+/* Reads the 'v', 'v/t', 'v//n' or 'v/t/n' tokens of a face record */
+static int obj_scan_vertex_index(const char *p, const char *end, int *vertex_index, int *texture_index,
+                                 int *normal_index)
+{
+    int vertex_count = 0;
+
+    for (int i = 0; i < MAX_VERTEX_COUNT; i++)
+    {
+        vertex_index[i] = 0;
+        texture_index[i] = 0;
+        normal_index[i] = 0;
+    }
+
+    p = obj_skip_space(p, end);
+    while (p < end && vertex_count < MAX_VERTEX_COUNT)
+    {
+        vertex_index[vertex_count] = obj_scan_int(&p, end);
+
+        if (p < end && *p == '/')
+        {
+            p++;
+            if (p < end && *p != '/')
+                texture_index[vertex_count] = obj_scan_int(&p, end);
+
+            if (p < end && *p == '/')
+            {
+                p++;
+                normal_index[vertex_count] = obj_scan_int(&p, end);
+            }
+        }
+
+        vertex_count++;
+        p = obj_skip_space(obj_skip_token(p, end), end);
+    }
+
+    return vertex_count;
+}
+
+static void obj_scan_face(obj_growable_scene_data *scene, const char *p, const char *end, int material_index)
+{
+    obj_face face;
+
+    face.vertex_count = obj_scan_vertex_index(p, end, face.vertex_index, face.texture_index, face.normal_index);
+    obj_convert_to_list_index_v(obj_vertex_count(scene), face.vertex_index);
+    obj_convert_to_list_index_v(obj_texture_count(scene), face.texture_index);
+    obj_convert_to_list_index_v(obj_normal_count(scene), face.normal_index);
+    face.material_index = material_index;
+    obj_add_face(scene, &face);
+}
+
+static inline int obj_token_is(const char *token, size_t length, const char *keyword)
+{
+    return strlen(keyword) == length && memcmp(token, keyword, length) == 0;
+}
+
+static void obj_scan_obj_data(obj_growable_scene_data *growable_data, const char *data, size_t size)
+{
+    int current_material = -1;
+    int line_number = 0;
+
+    const char *p = data;
+    const char *file_end = data + size;
+
+    while (p < file_end)
+    {
+        const char *line_end = (const char *) memchr(p, '\n', file_end - p);
+        if (line_end == nullptr)
+            line_end = file_end;
+
+        const char *line = p;
+        p = line_end + 1;
+        line_number++;
+
+        const char *token = obj_skip_space(line, line_end);
+        const char *token_end = obj_skip_token(token, line_end);
+        size_t token_length = token_end - token;
+
+        //skip comments and empty lines
+        if (token_length == 0 || token[0] == '#')
+            continue;
+
+        //the bulk of every file goes through the in-place scanner
+        if (obj_token_is(token, token_length, "v"))
         {
-            list_add_item(&growable_data->vertex_list, obj_parse_vector(), nullptr);
-        } else if (strequal(current_token, "vn")) //process vertex normal
+            obj_scan_vector(&growable_data->vertex_positions, token_end, line_end);
+        } else if (obj_token_is(token, token_length, "vn"))
         {
-            list_add_item(&growable_data->vertex_normal_list, obj_parse_vector(), nullptr);
-        } else if (strequal(current_token, "vt")) //process vertex texture
+            obj_scan_vector(&growable_data->vertex_normals, token_end, line_end);
+        } else if (obj_token_is(token, token_length, "vt"))
         {
-            list_add_item(&growable_data->vertex_texture_list, obj_parse_vector2(), nullptr);
-        } else if (strequal(current_token, "f")) //process face
+            obj_scan_vector2(&growable_data->vertex_uvs, token_end, line_end);
+        } else if (obj_token_is(token, token_length, "f"))
         {
-            obj_face *face = obj_parse_face(growable_data);
-            face->material_index = current_material;
-            list_add_item(&growable_data->face_list, face, nullptr);
-        } else if (strequal(current_token, "sp")) //process sphere
+            obj_scan_face(growable_data, token_end, line_end, current_material);
+        } else
         {
-            obj_sphere *sphr = obj_parse_sphere(growable_data);
-            sphr->material_index = current_material;
-            list_add_item(&growable_data->sphere_list, sphr, nullptr);
-        } else if (strequal(current_token, "pl")) //process plane
+            //rare records are copied out and handed to the strtok based parser
+            char current_line[OBJ_LINE_SIZE];
+            size_t length = line_end - line;
+            if (length >= OBJ_LINE_SIZE)
+                length = OBJ_LINE_SIZE - 1;
+            memcpy(current_line, line, length);
+            current_line[length] = '\0';
+
+            char *current_token = obj_strtok(current_line, WHITESPACE);
+            obj_parse_line(growable_data, current_token, line_number, current_line, &current_material);
+        }
+    }
+}
+
+int obj_parse_obj_file_mapped(obj_growable_scene_data *growable_data, const char *filename)
+{
+    mapped_file file;
+
+    if (!map_file(&file, filename))
+    {
+        fprintf(stderr, "Error reading file: %s\n", filename);
+        return 0;
+    }
+
+    obj_scan_obj_data(growable_data, file.data, file.size);
+    unmap_file(&file);
+
+    return 1;
+}
+
+/*----------------------------------------------------------------*/
+
+/*
+ * Parallel path: the mapped file is cut into chunks at line boundaries
+ * and each chunk is scanned by a worker into its own arrays. Indices
+ * and materials that depend on what came before the chunk (relative
+ * indices, 'usemtl' and 'mtllib') are only recorded by the workers and
+ * resolved afterwards in file order, so the result matches the serial
+ * parser exactly. Files with other record types are parsed serially.
+ */
+
+/* 'usemtl' or 'mtllib' directive, replayed in file order during the merge */
+typedef struct
+{
+    int face_position; // number of chunk faces read before the directive
+    char is_library;
+    std::string name;
+} obj_chunk_directive;
+
+/* Face entries written as negative (relative) indices, bit (kind * MAX_VERTEX_COUNT + vertex) */
+typedef struct
+{
+    int face;
+    unsigned short mask;
+} obj_chunk_relative;
+
+typedef struct
+{
+    const char *begin;
+    const char *end;
+
+    /* same layout as obj_growable_scene_data */
+    std::vector<float> positions;
+    std::vector<float> normals;
+    std::vector<float> uvs;
+    std::vector<int> vertex_index;
+    std::vector<int> normal_index;
+    std::vector<int> texture_index;
+    std::vector<int> vertex_count;
+    std::vector<int> material_index;
+
+    std::vector<obj_chunk_relative> relative;
+    std::vector<obj_chunk_directive> directives;
+
+    int needs_serial; // chunk holds records only the serial parser handles
+
+    /* filled by the merge */
+    int vertex_base;
+    int normal_base;
+    int texture_base;
+    int face_base;
+    std::vector<int> directive_materials; // material after each directive
+    int start_material;                   // material active at the chunk start
+} obj_chunk;
+
+/* Converts a chunk-local index; relative ones stay chunk-local and are flagged */
+static inline int obj_chunk_index(int current_count, int index, int kind, int vertex, unsigned short *mask)
+{
+    if (index < 0)
+    {
+        *mask |= 1 << (kind * MAX_VERTEX_COUNT + vertex);
+        return current_count + index;
+    }
+    return obj_convert_to_list_index(current_count, index);
+}
+
+static void obj_scan_chunk(obj_chunk *chunk)
+{
+    const char *p = chunk->begin;
+    const char *chunk_end = chunk->end;
+
+    while (p < chunk_end && !chunk->needs_serial)
+    {
+        const char *line_end = (const char *) memchr(p, '\n', chunk_end - p);
+        if (line_end == nullptr)
+            line_end = chunk_end;
+
+        const char *line = p;
+        p = line_end + 1;
+
+        const char *token = obj_skip_space(line, line_end);
+        const char *token_end = obj_skip_token(token, line_end);
+        size_t token_length = token_end - token;
+
+        if (token_length == 0 || token[0] == '#')
+            continue;
+
+        if (obj_token_is(token, token_length, "v"))
         {
-            obj_plane *pl = obj_parse_plane(growable_data);
-            pl->material_index = current_material;
-            list_add_item(&growable_data->plane_list, pl, nullptr);
-        } else if (strequal(current_token, "p")) //process point
+            obj_scan_vector(&chunk->positions, token_end, line_end);
+        } else if (obj_token_is(token, token_length, "vn"))
         {
-            //make a small sphere to represent the point?
-        } else if (strequal(current_token, "lp")) //light point source
+            obj_scan_vector(&chunk->normals, token_end, line_end);
+        } else if (obj_token_is(token, token_length, "vt"))
         {
-            obj_light_point *o = obj_parse_light_point(growable_data);
-            o->material_index = current_material;
-            list_add_item(&growable_data->light_point_list, o, nullptr);
-        } else if (strequal(current_token, "ld")) //process light disc
+            obj_scan_vector2(&chunk->uvs, token_end, line_end);
+        } else if (obj_token_is(token, token_length, "f"))
         {
-            obj_light_disc *o = obj_parse_light_disc(growable_data);
-            o->material_index = current_material;
-            list_add_item(&growable_data->light_disc_list, o, nullptr);
-        } else if (strequal(current_token, "lq")) //process light quad
+            obj_face face;
+            unsigned short mask = 0;
+            int vertices = chunk->positions.size() / 3;
+            int normals = chunk->normals.size() / 3;
+            int textures = chunk->uvs.size() / 2;
+
+            face.vertex_count = obj_scan_vertex_index(token_end, line_end, face.vertex_index,
+                                                      face.texture_index, face.normal_index);
+            for (int i = 0; i < MAX_VERTEX_COUNT; i++)
+            {
+                chunk->vertex_index.push_back(obj_chunk_index(vertices, face.vertex_index[i], 0, i, &mask));
+                chunk->texture_index.push_back(obj_chunk_index(textures, face.texture_index[i], 1, i, &mask));
+                chunk->normal_index.push_back(obj_chunk_index(normals, face.normal_index[i], 2, i, &mask));
+            }
+
+            if (mask != 0)
+                chunk->relative.push_back(obj_chunk_relative{(int) chunk->vertex_count.size(), mask});
+            chunk->vertex_count.push_back(face.vertex_count);
+        } else if (obj_token_is(token, token_length, "usemtl") || obj_token_is(token, token_length, "mtllib"))
         {
-            obj_light_quad *o = obj_parse_light_quad(growable_data);
-            o->material_index = current_material;
-            list_add_item(&growable_data->light_quad_list, o, nullptr);
-        } else if (strequal(current_token, "c")) //camera
+            const char *name = obj_skip_space(token_end, line_end);
+            obj_chunk_directive directive;
+            directive.face_position = chunk->vertex_count.size();
+            directive.is_library = token[0] == 'm';
+            directive.name.assign(name, obj_skip_token(name, line_end));
+            chunk->directives.push_back(directive);
+        } else if (!obj_token_is(token, token_length, "o") && !obj_token_is(token, token_length, "s") &&
+                   !obj_token_is(token, token_length, "g") && !obj_token_is(token, token_length, "p"))
         {
-            growable_data->camera = (obj_camera *) malloc(sizeof(obj_camera));
-            obj_parse_camera(growable_data, growable_data->camera);
-        } else if (strequal(current_token, "usemtl")) // usemtl
+            chunk->needs_serial = 1;
+        }
+    }
+}
+
+/* Shifts chunk-local indices to file indices and assigns the materials */
+static void obj_fixup_chunk(obj_chunk *chunk)
+{
+    for (const obj_chunk_relative &rel : chunk->relative)
+    {
+        int first = rel.face * MAX_VERTEX_COUNT;
+        for (int i = 0; i < MAX_VERTEX_COUNT; i++)
         {
-            current_material = list_find(&growable_data->material_list, strtok(NULL, WHITESPACE));
-        } else if (strequal(current_token, "mtllib")) // mtllib
+            if (rel.mask & (1 << i))
+                chunk->vertex_index[first + i] += chunk->vertex_base;
+            if (rel.mask & (1 << (MAX_VERTEX_COUNT + i)))
+                chunk->texture_index[first + i] += chunk->texture_base;
+            if (rel.mask & (1 << (2 * MAX_VERTEX_COUNT + i)))
+                chunk->normal_index[first + i] += chunk->normal_base;
+        }
+    }
+
+    int material = chunk->start_material;
+    size_t directive = 0;
+    size_t face_count = chunk->vertex_count.size();
+    chunk->material_index.resize(face_count);
+    for (size_t i = 0; i < face_count; i++)
+    {
+        while (directive < chunk->directives.size() && chunk->directives[directive].face_position <= (int) i)
+            material = chunk->directive_materials[directive++];
+        chunk->material_index[i] = material;
+    }
+}
+
+/* Runs job(0) .. job(count - 1) on 'threads' workers, handing out jobs in order */
+template<typename Job>
+static void obj_run_workers(int count, int threads, Job job)
+{
+    std::atomic<int> next(0);
+    std::vector<std::thread> workers;
+
+    auto worker = [&]()
+    {
+        for (int i = next++; i < count; i = next++)
+            job(i);
+    };
+
+    for (int t = 1; t < threads; t++)
+        workers.emplace_back(worker);
+    worker();
+
+    for (std::thread &t : workers)
+        t.join();
+}
+
+template<typename T>
+static void obj_copy_at(const std::vector<T> &from, std::vector<T> *to, size_t offset)
+{
+    std::copy(from.begin(), from.end(), to->begin() + offset);
+}
+
+int obj_parse_obj_file_parallel(obj_growable_scene_data *growable_data, const char *filename, int threads)
+{
+    mapped_file file;
+
+    if (!map_file(&file, filename))
+    {
+        fprintf(stderr, "Error reading file: %s\n", filename);
+        return 0;
+    }
+
+    if (threads <= 0)
+        threads = std::max(1u, std::thread::hardware_concurrency());
+
+    /* a few chunks per worker keeps them busy when chunks differ in cost */
+    size_t chunk_count = threads * 4;
+    size_t min_chunk_size = 64 * 1024;
+    if (file.size / min_chunk_size < chunk_count)
+        chunk_count = std::max<size_t>(1, file.size / min_chunk_size);
+
+    std::vector<obj_chunk> chunks(chunk_count);
+    const char *begin = file.data;
+    const char *file_end = file.data + file.size;
+    for (size_t i = 0; i < chunk_count; i++)
+    {
+        const char *end = file.data + file.size * (i + 1) / chunk_count;
+        if (end < begin)
+            end = begin;
+        const char *line_end = (const char *) memchr(end, '\n', file_end - end);
+        end = (i + 1 == chunk_count || line_end == nullptr) ? file_end : line_end + 1;
+
+        chunks[i].begin = begin;
+        chunks[i].end = end;
+        chunks[i].needs_serial = 0;
+        begin = end;
+    }
+
+    obj_run_workers(chunk_count, threads, [&](int i) { obj_scan_chunk(&chunks[i]); });
+
+    for (obj_chunk &chunk : chunks)
+    {
+        if (chunk.needs_serial)
         {
-            strncpy(growable_data->material_filename, strtok(NULL, WHITESPACE), OBJ_FILENAME_LENGTH);
-            obj_parse_mtl_file(growable_data->material_filename, &growable_data->material_list);
-            continue;
-        } else if (strequal(current_token, "o")) //object name
-        {}
-        else if (strequal(current_token, "s")) //smoothing
-        {}
-        else if (strequal(current_token, "g")) // group
-        {}
-
-        else
+            chunks.clear();
+            obj_scan_obj_data(growable_data, file.data, file.size);
+            unmap_file(&file);
+            return 1;
+        }
+    }
+
+    /* deterministic merge: bases and directives in file order */
+    int vertex_count = 0, normal_count = 0, texture_count = 0, face_count = 0;
+    int current_material = -1;
+    for (obj_chunk &chunk : chunks)
+    {
+        chunk.vertex_base = vertex_count;
+        chunk.normal_base = normal_count;
+        chunk.texture_base = texture_count;
+        chunk.face_base = face_count;
+        vertex_count += chunk.positions.size() / 3;
+        normal_count += chunk.normals.size() / 3;
+        texture_count += chunk.uvs.size() / 2;
+        face_count += chunk.vertex_count.size();
+
+        chunk.start_material = current_material;
+        for (obj_chunk_directive &directive : chunk.directives)
         {
-            printf("Unknown command '%s' in scene code at line %i: \"%s\".\n",
-                   current_token, line_number, current_line);
+            if (directive.is_library)
+            {
+                snprintf(growable_data->material_filename, OBJ_FILENAME_LENGTH, "%s", directive.name.c_str());
+                obj_parse_mtl_file(growable_data->material_filename, &growable_data->material_list);
+            } else
+            {
+                current_material = list_find(&growable_data->material_list, &directive.name[0]);
+            }
+            chunk.directive_materials.push_back(current_material);
         }
     }
 
-    fclose(obj_file_stream);
+    growable_data->vertex_positions.resize(vertex_count * 3);
+    growable_data->vertex_normals.resize(normal_count * 3);
+    growable_data->vertex_uvs.resize(texture_count * 2);
+    growable_data->face_vertex_index.resize(face_count * MAX_VERTEX_COUNT);
+    growable_data->face_normal_index.resize(face_count * MAX_VERTEX_COUNT);
+    growable_data->face_texture_index.resize(face_count * MAX_VERTEX_COUNT);
+    growable_data->face_vertex_count.resize(face_count);
+    growable_data->face_material_index.resize(face_count);
+
+    obj_run_workers(chunk_count, threads, [&](int i)
+    {
+        obj_chunk &chunk = chunks[i];
+        obj_fixup_chunk(&chunk);
+        obj_copy_at(chunk.positions, &growable_data->vertex_positions, chunk.vertex_base * 3);
+        obj_copy_at(chunk.normals, &growable_data->vertex_normals, chunk.normal_base * 3);
+        obj_copy_at(chunk.uvs, &growable_data->vertex_uvs, chunk.texture_base * 2);
+        obj_copy_at(chunk.vertex_index, &growable_data->face_vertex_index, chunk.face_base * MAX_VERTEX_COUNT);
+        obj_copy_at(chunk.normal_index, &growable_data->face_normal_index, chunk.face_base * MAX_VERTEX_COUNT);
+        obj_copy_at(chunk.texture_index, &growable_data->face_texture_index, chunk.face_base * MAX_VERTEX_COUNT);
+        obj_copy_at(chunk.vertex_count, &growable_data->face_vertex_count, chunk.face_base);
+        obj_copy_at(chunk.material_index, &growable_data->face_material_index, chunk.face_base);
+    });
+
+    unmap_file(&file);
 
     return 1;
 }
 
-
 void obj_init_temp_storage(obj_growable_scene_data *growable_data)
 {
-    list_make(&growable_data->vertex_list, 10, 1);
-    list_make(&growable_data->vertex_normal_list, 10, 1);
-    list_make(&growable_data->vertex_texture_list, 10, 1);
-
-    list_make(&growable_data->face_list, 10, 1);
     list_make(&growable_data->sphere_list, 10, 1);
     list_make(&growable_data->plane_list, 10, 1);
 
@@ -454,11 +998,6 @@ void obj_init_temp_storage(obj_growable_scene_data *growable_data)
 
 void obj_free_temp_storage(obj_growable_scene_data *growable_data)
 {
-    obj_free_half_list(&growable_data->vertex_list);
-    obj_free_half_list(&growable_data->vertex_normal_list);
-    obj_free_half_list(&growable_data->vertex_texture_list);
-
-    obj_free_half_list(&growable_data->face_list);
     obj_free_half_list(&growable_data->sphere_list);
     obj_free_half_list(&growable_data->plane_list);
 
@@ -469,23 +1008,33 @@ void obj_free_temp_storage(obj_growable_scene_data *growable_data)
     obj_free_half_list(&growable_data->material_list);
 }
 
+/* After a failed parse nothing was handed to the output, so the items go as well */
+void obj_free_failed_temp_storage(obj_growable_scene_data *growable_data)
+{
+    list *lists[] = {&growable_data->sphere_list, &growable_data->plane_list, &growable_data->light_point_list,
+                     &growable_data->light_quad_list, &growable_data->light_disc_list,
+                     &growable_data->material_list};
+    for (list *listo : lists)
+    {
+        for (int i = 0; i < listo->item_count; i++)
+            free(listo->items[i]);
+    }
+
+    obj_free_temp_storage(growable_data);
+    for (list *listo : lists)
+        free(listo->items);
+
+    free(growable_data->camera);
+    growable_data->camera = NULL;
+}
+
 void delete_obj_data(obj_scene_data *data_out)
 {
     int i;
 
-    for (i = 0; i < data_out->vertex_count; i++)
-        free(data_out->vertex_list[i]);
-    free(data_out->vertex_list);
-    for (i = 0; i < data_out->vertex_normal_count; i++)
-        free(data_out->vertex_normal_list[i]);
-    free(data_out->vertex_normal_list);
-    for (i = 0; i < data_out->vertex_texture_count; i++)
-        free(data_out->vertex_texture_list[i]);
-    free(data_out->vertex_texture_list);
-
-    for (i = 0; i < data_out->face_count; i++)
-        free(data_out->face_list[i]);
-    free(data_out->face_list);
+    /* all vertex and face arrays */
+    free(data_out->arena);
+
     for (i = 0; i < data_out->sphere_count; i++)
         free(data_out->sphere_list[i]);
     free(data_out->sphere_list);
@@ -510,13 +1059,43 @@ void delete_obj_data(obj_scene_data *data_out)
     free(data_out->camera);
 }
 
+/* Bump allocator handing out the output arrays from a single block */
+typedef struct
+{
+    char *base;
+    size_t used;
+} obj_arena;
+
+#define OBJ_ARENA_ALIGN 64
+
+template<typename T>
+static size_t obj_arena_size(const std::vector<T> &v)
+{
+    return (v.size() * sizeof(T) + OBJ_ARENA_ALIGN - 1) & ~(size_t) (OBJ_ARENA_ALIGN - 1);
+}
+
+static void obj_arena_make(obj_arena *arena, size_t size)
+{
+    arena->base = (char *) malloc(size > 0 ? size : 1);
+    arena->used = 0;
+}
+
+template<typename T>
+static T *obj_arena_copy(obj_arena *arena, const std::vector<T> &v)
+{
+    T *out = (T *) (arena->base + arena->used);
+    memcpy(out, v.data(), v.size() * sizeof(T));
+    arena->used += obj_arena_size(v);
+    return out;
+}
+
 void obj_copy_to_out_storage(obj_scene_data *data_out, obj_growable_scene_data *growable_data)
 {
-    data_out->vertex_count = growable_data->vertex_list.item_count;
-    data_out->vertex_normal_count = growable_data->vertex_normal_list.item_count;
-    data_out->vertex_texture_count = growable_data->vertex_texture_list.item_count;
+    data_out->vertex_count = obj_vertex_count(growable_data);
+    data_out->vertex_normal_count = obj_normal_count(growable_data);
+    data_out->vertex_texture_count = obj_texture_count(growable_data);
 
-    data_out->face_count = growable_data->face_list.item_count;
+    data_out->face_count = growable_data->face_vertex_count.size();
     data_out->sphere_count = growable_data->sphere_list.item_count;
     data_out->plane_count = growable_data->plane_list.item_count;
 
@@ -526,11 +1105,27 @@ void obj_copy_to_out_storage(obj_scene_data *data_out, obj_growable_scene_data *
 
     data_out->material_count = growable_data->material_list.item_count;
 
-    data_out->vertex_list = (obj_vector **) growable_data->vertex_list.items;
-    data_out->vertex_normal_list = (obj_vector **) growable_data->vertex_normal_list.items;
-    data_out->vertex_texture_list = (obj_vector2 **) growable_data->vertex_texture_list.items;
-
-    data_out->face_list = (obj_face **) growable_data->face_list.items;
+    /* one allocation for every vertex and face array */
+    obj_arena arena;
+    obj_arena_make(&arena, obj_arena_size(growable_data->vertex_positions) +
+                           obj_arena_size(growable_data->vertex_normals) +
+                           obj_arena_size(growable_data->vertex_uvs) +
+                           obj_arena_size(growable_data->face_vertex_index) +
+                           obj_arena_size(growable_data->face_normal_index) +
+                           obj_arena_size(growable_data->face_texture_index) +
+                           obj_arena_size(growable_data->face_vertex_count) +
+                           obj_arena_size(growable_data->face_material_index));
+    data_out->arena = arena.base;
+
+    data_out->vertex_positions = obj_arena_copy(&arena, growable_data->vertex_positions);
+    data_out->vertex_normals = obj_arena_copy(&arena, growable_data->vertex_normals);
+    data_out->vertex_uvs = obj_arena_copy(&arena, growable_data->vertex_uvs);
+
+    data_out->face_vertex_index = obj_arena_copy(&arena, growable_data->face_vertex_index);
+    data_out->face_normal_index = obj_arena_copy(&arena, growable_data->face_normal_index);
+    data_out->face_texture_index = obj_arena_copy(&arena, growable_data->face_texture_index);
+    data_out->face_vertex_count = obj_arena_copy(&arena, growable_data->face_vertex_count);
+    data_out->face_material_index = obj_arena_copy(&arena, growable_data->face_material_index);
     data_out->sphere_list = (obj_sphere **) growable_data->sphere_list.items;
     data_out->plane_list = (obj_plane **) growable_data->plane_list.items;
 
@@ -543,16 +1138,38 @@ void obj_copy_to_out_storage(obj_scene_data *data_out, obj_growable_scene_data *
     data_out->camera = growable_data->camera;
 }
 
-int parse_obj_scene(obj_scene_data *data_out, const char *filename)
+int parse_obj_scene_mode(obj_scene_data *data_out, const char *filename, obj_parse_mode mode, int threads)
 {
     obj_growable_scene_data growable_data;
+    int success;
 
     obj_init_temp_storage(&growable_data);
-    if (obj_parse_obj_file(&growable_data, filename) == 0)
+    if (mode == OBJ_PARSE_AUTO)
+    {
+        /* below a few megabytes the thread start-up is not worth it */
+        struct stat st;
+        mode = (stat(filename, &st) == 0 && st.st_size >= OBJ_PARALLEL_MIN_SIZE) ? OBJ_PARSE_PARALLEL : OBJ_PARSE_MAPPED;
+    }
+
+    if (mode == OBJ_PARSE_STDIO)
+        success = obj_parse_obj_file(&growable_data, filename);
+    else if (mode == OBJ_PARSE_PARALLEL)
+        success = obj_parse_obj_file_parallel(&growable_data, filename, threads);
+    else
+        success = obj_parse_obj_file_mapped(&growable_data, filename);
+
+    if (success == 0)
+    {
+        obj_free_failed_temp_storage(&growable_data);
         return 0;
+    }
 
     obj_copy_to_out_storage(data_out, &growable_data);
     obj_free_temp_storage(&growable_data);
     return 1;
 }
 
+int parse_obj_scene(obj_scene_data *data_out, const char *filename)
+{
+    return parse_obj_scene_mode(data_out, filename, OBJ_PARSE_AUTO);
+}
@@ -15,6 +15,7 @@
 #define OBJ_PARSER_H
 
 #include <string>
+#include <vector>
 #include "List.h"
 #include "StringExtra.h"
 #include "cstring"
@@ -51,16 +52,6 @@ typedef struct
 	int material_index;
 } obj_plane;
 
-typedef struct
-{
-	double e[3];
-} obj_vector;
-
-typedef struct
-{
-	double e[2];
-} obj_vector2;
-
 
 typedef struct
 {
@@ -105,15 +96,19 @@ typedef struct
 
 typedef struct
 {
-//	vector extreme_dimensions[2];
 	char scene_filename[OBJ_FILENAME_LENGTH];
 	char material_filename[OBJ_FILENAME_LENGTH];
 	
-	list vertex_list;
-	list vertex_normal_list;
-	list vertex_texture_list;
+	std::vector<float> vertex_positions;	// x, y, z per vertex
+	std::vector<float> vertex_normals;	// x, y, z per normal
+	std::vector<float> vertex_uvs;		// u, v per texture coordinate
+	
+	std::vector<int> face_vertex_index;	// MAX_VERTEX_COUNT entries per face
+	std::vector<int> face_normal_index;
+	std::vector<int> face_texture_index;
+	std::vector<int> face_vertex_count;
+	std::vector<int> face_material_index;
 	
-	list face_list;
 	list sphere_list;
 	list plane_list;
 	
@@ -126,13 +121,24 @@ typedef struct
 	obj_camera *camera;
 } obj_growable_scene_data;
 
+/*
+ * Vertex and face data live in contiguous structure-of-arrays buffers
+ * carved out of one arena allocation. Face i uses the entries
+ * [i * MAX_VERTEX_COUNT, i * MAX_VERTEX_COUNT + face_vertex_count[i])
+ * of the face_*_index arrays; unused entries are -1.
+ */
 typedef struct
 {
-	obj_vector **vertex_list;
-	obj_vector **vertex_normal_list;
-	obj_vector2 **vertex_texture_list;
+	float *vertex_positions;
+	float *vertex_normals;
+	float *vertex_uvs;
+	
+	int *face_vertex_index;
+	int *face_normal_index;
+	int *face_texture_index;
+	int *face_vertex_count;
+	int *face_material_index;
 	
-	obj_face **face_list;
 	obj_sphere **sphere_list;
 	obj_plane **plane_list;
 	
@@ -157,9 +163,21 @@ typedef struct
 	int material_count;
 
 	obj_camera *camera;
+
+	void *arena;	// backs the vertex_* and face_* arrays; freed by delete_obj_data
 } obj_scene_data;
 
+typedef enum
+{
+	OBJ_PARSE_STDIO,	// fgets/strtok/atof, one line buffer at a time
+	OBJ_PARSE_MAPPED,	// file is memory-mapped and scanned in place
+	OBJ_PARSE_PARALLEL,	// mapped file split into chunks scanned by all cores
+	OBJ_PARSE_AUTO		// parallel for large files, mapped otherwise
+} obj_parse_mode;
+
 int parse_obj_scene(obj_scene_data *data_out, const char* filename);
+// threads = 0 uses one worker per core (parallel mode only)
+int parse_obj_scene_mode(obj_scene_data *data_out, const char* filename, obj_parse_mode mode, int threads = 0);
 void delete_obj_data(obj_scene_data *data_out);
 
 #endif
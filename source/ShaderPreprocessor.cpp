@@ -0,0 +1,105 @@
+/******************************************************************
+*
+* ShaderPreprocessor.cpp
+*
+* Description: Expands the #include "file" lines of a shader and
+* inserts the #defines of a program variant after its #version
+* line, so that the GLSL compiler specializes the shader instead of
+* branching at run time.
+*
+*******************************************************************/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <vector>
+
+#include "ShaderPreprocessor.hpp"
+#include "LoadShader.h"
+
+using namespace std;
+
+/* Returns whether 'line' is the preprocessor directive 'directive', possibly indented */
+static int isDirective(const string &line, const char *directive, size_t *end)
+{
+    size_t first = line.find_first_not_of(" \t");
+    size_t length = char_traits<char>::length(directive);
+    if (first == string::npos || line.compare(first, length, directive) != 0)
+        return 0;
+
+    *end = first + length;
+    return 1;
+}
+
+/******************************************************************
+*
+* @brief Appends a file to 'output', replacing its includes by the
+* files they name. Every file is a GLSL source string number for
+* the #line directives, in the order the files are first included.
+*
+* @param defines = inserted after the #version line, or empty
+* @param included = paths of the files expanded so far
+*******************************************************************/
+static void expand(const string &path, const string &defines, vector<string> *included, string *output)
+{
+    int number = included->size();
+    included->push_back(path);
+
+    const char *text = LoadShader(path.c_str());
+    istringstream lines(text);
+    free((void *) text);
+
+    string directory = path.substr(0, path.find_last_of("/\\") + 1);
+
+    if (number > 0)
+        *output += "#line 1 " + to_string(number) + "\n";
+
+    string line;
+    int lineNumber = 0;
+    while (getline(lines, line))
+    {
+        lineNumber++;
+        size_t end;
+
+        if (isDirective(line, "#include", &end))
+        {
+            size_t open = line.find('"', end);
+            size_t close = open == string::npos ? string::npos : line.find('"', open + 1);
+            if (close == string::npos)
+            {
+                fprintf(stderr, "Malformed #include in %s, line %d\n", path.c_str(), lineNumber);
+                exit(1);
+            }
+
+            /* a file that was included before is left out, which also ends include cycles */
+            string file = directory + line.substr(open + 1, close - open - 1);
+            if (find(included->begin(), included->end(), file) == included->end())
+            {
+                expand(file, "", included, output);
+                *output += "#line " + to_string(lineNumber + 1) + " " + to_string(number) + "\n";
+            } else
+            {
+                *output += "\n";
+            }
+            continue;
+        }
+
+        *output += line + "\n";
+
+        /* defines must follow #version, which has to come first */
+        if (!defines.empty() && isDirective(line, "#version", &end))
+        {
+            *output += defines;
+            *output += "#line " + to_string(lineNumber + 1) + " " + to_string(number) + "\n";
+        }
+    }
+}
+
+string PreprocessShader(const string &path, const string &defines)
+{
+    vector<string> included;
+    string output;
+    expand(path, defines, &included, &output);
+    return output;
+}
@@ -0,0 +1,21 @@
+/******************************************************************
+*
+* ShaderPreprocessor.hpp
+*
+* Description: Expands the #include "file" lines of a shader and
+* inserts the #defines of a program variant after its #version
+* line, so that the GLSL compiler specializes the shader instead of
+* branching at run time.
+*
+*******************************************************************/
+
+#ifndef SHADER_PREPROCESSOR_H
+#define SHADER_PREPROCESSOR_H
+
+#include <string>
+
+/* Returns the source of 'path' with all includes expanded (paths relative to the including file, every file
+ * at most once) and 'defines' after the #version line; #line directives keep the line numbers of errors */
+std::string PreprocessShader(const std::string &path, const std::string &defines);
+
+#endif /* SHADER_PREPROCESSOR_H */
@@ -3,21 +3,33 @@
 
 /******************************************************************
 *
-* @brief Constructs a new Arm object (with static base)
+* @brief Constructs a new Arm object (with static base); the meshes
+* and textures are shared through 'assets'
 *
 *******************************************************************/
-Arm::Arm(Camera *_cam) :
-    internal{0}, cam(_cam)
+Arm::Arm(Camera *_cam, AssetRegistry *_assets) :
+    internal{0}, cam(_cam), assets(_assets)
 {
     // base
     string modelPath = "../models/base.obj";
     string texturePath = "../textures/malachite.bmp";
 
-    SetupTexture(&TextureID, texturePath.c_str());
-    readMeshFile(modelPath, 1.5f, &NBO, &VAO);
+    TextureID = assets->acquireTexture(texturePath);
+    mesh = assets->acquireMesh(modelPath, 1.5f);
     SetIdentityMatrix(internal);
 }
 
+/** Deletes the limbs and releases the base's mesh and texture */
+Arm::~Arm()
+{
+    for (auto limb : limbs)
+    {
+        delete limb;
+    }
+    assets->releaseMesh(mesh);
+    assets->releaseTexture(TextureID);
+}
+
 /******************************************************************
 *
 * @brief adds a new limb to the arm
@@ -36,7 +48,7 @@ void Arm::addLimb(string filename, string texture, float offset, float scale)
 
     float pos[] = {center, offset, center};
 
-    limbs.push_back(new Limb(this, currentIndex, filename, texture, pos, scale));
+    limbs.push_back(new Limb(this, currentIndex, filename, texture, pos, scale, assets));
 }
 
 /******************************************************************
@@ -65,7 +77,8 @@ void Arm::update(KeyboardState *state)
     {
         float transformation[16];
         float rot;
-        SetIdentityMatrix(transformation);
+        // the first limb sits on the base
+        memcpy(transformation, internal, 16 * sizeof(float));
 
         // rotate along the axis chosen via keyboard
         if (state->currentLimb != 0 && state->currentLimb - 1 == i)
@@ -112,47 +125,49 @@ float Arm::getCurrentRotationAt(int axis, Limb *limb)
     return constrainAngle(temp);
 }
 
-void Arm::display(GLint program)
+/** Returns the camera the arm is viewed with */
+Camera *Arm::getCamera()
 {
-    glUseProgram(program);
+    return cam;
+}
 
-    GLint size;
-    glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &size);
+/** Moves the base (and with it the whole arm) to a point in the world */
+void Arm::setPosition(float x, float y, float z)
+{
+    SetTranslation(x, y, z, internal);
+}
 
-    GLint ModelUniform = glGetUniformLocation(program, "TransformMatrix");
-    if (ModelUniform == -1)
+/******************************************************************
+*
+* @brief Gives every limb random joint angles, so that arms of a
+* fleet do not all look the same
+*
+* @param random = random number engine, advanced by the call
+*******************************************************************/
+void Arm::randomizePose(minstd_rand *random)
+{
+    for (auto limb : limbs)
     {
-        fprintf(stderr, "Could not bind uniform Transform Matrix for Arm.\n");
-        exit(-1);
+        limb->setPose((*random)() % 90 - 45.0f, (*random)() % 360);
     }
-    glUniformMatrix4fv(ModelUniform, 1, GL_TRUE, internal);
-
-    /* Bind VAO of the current object */
-    glBindVertexArray(VAO);
-    /* Draw the data contained in the VAO */
-    glDrawElements(GL_TRIANGLES, size / sizeof(GLushort), GL_UNSIGNED_SHORT, nullptr);
-
-    /* Activate first (and only) texture unit */
-    glActiveTexture(GL_TEXTURE0);
-
-    /* Bind current texture  */
-    glBindTexture(GL_TEXTURE_2D, TextureID);
-
-    /* Get texture uniform handle from fragment shader */
-    TextureUniform  = glGetUniformLocation(program, "tex");
-    /* Set location of uniform sampler variable */
-    glUniform1i(TextureUniform, 0);
-
-    /* Uniform integer used to enable/disable texture mapping */
-    GLint UseTexUniform = glGetUniformLocation(program, "UseTexture");
+}
 
-    glUniform1i(UseTexUniform, 1);
-    /* Use filled polygons rendering */
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+/******************************************************************
+*
+* @brief Adds the base and all limbs to a scene snapshot; the render
+* thread draws them together with all other arms
+*
+*******************************************************************/
+void Arm::snapshot(SceneSnapshot *scene)
+{
+    SnapshotItem item;
+    item.mesh = mesh;
+    item.texture = TextureID;
+    memcpy(item.model, internal, 16 * sizeof(float));
+    scene->items.push_back(item);
 
-    glBindVertexArray(0);
     for (auto limb : limbs)
     {
-        limb->display(program);
+        limb->snapshot(scene);
     }
 }
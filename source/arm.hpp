@@ -4,10 +4,13 @@
 #include <cstdlib>
 #include <cstdio>
 #include <iostream>
+#include <random>
 #include <vector>
 #include "utils.hpp"
 #include "limb.hpp"
 #include "camera.hpp"
+#include "scenesnapshot.hpp"
+#include "assetregistry.hpp"
 #include "Vector.hpp"
 
 using namespace std;
@@ -18,26 +21,34 @@ class Arm
 private:
     std::vector<Limb *> limbs;
 
-    GLuint VAO;
-    GLuint NBO; // normals
+    const Mesh *mesh;
 
-    GLuint TextureID;
-    GLuint TextureUniform;
+    const GLuint *TextureID;
 
+    // internal places the base in the world
     float internal[16];
 
     Camera *cam;
+    AssetRegistry *assets;
 
 public:
-    explicit Arm(Camera *cam);
+    Arm(Camera *cam, AssetRegistry *assets);
+
+    ~Arm();
 
     void addLimb(std::string filename, string texture, float offset, float scale);
 
     void update(KeyboardState *state);
 
-    void display(GLint ShaderProgram);
+    void setPosition(float x, float y, float z);
+
+    void randomizePose(minstd_rand *random);
+
+    void snapshot(SceneSnapshot *scene);
 
     static float getCurrentRotationAt(int axis, Limb *limb);
+
+    Camera *getCamera();
 };
 
 #endif /* ARM_H */
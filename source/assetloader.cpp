@@ -0,0 +1,293 @@
+#include "assetloader.hpp"
+#include "glstate.hpp"
+
+/******************************************************************
+*
+* @brief Starts the worker threads and creates the placeholder
+* texture; needs a current GL context
+*
+* @param threads = number of workers, 0 picks one per spare core
+*******************************************************************/
+AssetLoader::AssetLoader(GeometryPool *_pool, int threads) :
+        stopping(0), pending(0), pool(_pool)
+{
+    if (threads <= 0)
+    {
+        threads = (int) thread::hardware_concurrency() - 1;
+        threads = threads < 1 ? 1 : (threads > 4 ? 4 : threads);
+    }
+
+    /* White, so that unlit surfaces still show their shading */
+    const unsigned char white[3] = {255, 255, 255};
+    glGenTextures(1, &placeholderTexture);
+    GLState::bindTexture(GL_TEXTURE_2D, placeholderTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 1, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, white);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    for (int i = 0; i < threads; i++)
+        workers.emplace_back(&AssetLoader::work, this);
+}
+
+/** Stops the workers; assets that are not resident yet are dropped, which needs a current GL context */
+AssetLoader::~AssetLoader()
+{
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = 1;
+    }
+    wake.notify_all();
+
+    for (auto &worker : workers)
+        worker.join();
+
+    for (deque<AssetJob *> *queue : {&requested, &loaded})
+    {
+        for (AssetJob *job : *queue)
+        {
+            if (job->kind == ASSET_MESH && job->success)
+                CloseMeshView(&job->view);
+            if (job->kind == ASSET_TEXTURE && job->success)
+                free(job->image.data);
+
+            /* a job interrupted during its upload already holds pool ranges or a texture */
+            if (job->kind == ASSET_MESH && job->started)
+                pool->release(&job->uploading);
+            if (job->kind == ASSET_TEXTURE && job->started)
+                GLState::deleteTexture(job->textureID);
+            delete job;
+        }
+    }
+}
+
+/******************************************************************
+*
+* @brief Worker thread: parses OBJ files (or maps their cache
+* entries) and decodes BMP files; no GL calls are made here
+*
+*******************************************************************/
+void AssetLoader::work()
+{
+    for (;;)
+    {
+        AssetJob *job;
+        {
+            unique_lock<mutex> guard(lock);
+            wake.wait(guard, [this] { return stopping || !requested.empty(); });
+            if (stopping)
+                return;
+
+            job = requested.front();
+            requested.pop_front();
+        }
+
+        /* the workers already load side by side, so each one parses a mesh on its own thread */
+        if (job->kind == ASSET_MESH)
+            job->success = LoadMesh(job->path, job->scale, &job->options, &job->storage, &job->view, 1);
+        else
+            job->success = LoadTexture(job->path.c_str(), &job->image);
+
+        lock_guard<mutex> guard(lock);
+        loaded.push_back(job);
+    }
+}
+
+void AssetLoader::enqueue(AssetJob *job)
+{
+    job->success = 0;
+    job->uploaded = 0;
+    job->started = 0;
+    job->textureID = 0;
+    memset(&job->uploading, 0, sizeof(Mesh));
+
+    {
+        lock_guard<mutex> guard(lock);
+        requested.push_back(job);
+        pending++;
+    }
+    wake.notify_one();
+}
+
+/******************************************************************
+*
+* @brief Requests a mesh; returns immediately. 'mesh' has no levels
+* of detail until the mesh is resident and must stay valid until then.
+*
+*******************************************************************/
+void AssetLoader::loadMesh(const string &path, float scale, const MeshImportOptions *options, Mesh *mesh)
+{
+    memset(mesh, 0, sizeof(Mesh));
+
+    auto *job = new AssetJob();
+    job->kind = ASSET_MESH;
+    job->path = path;
+    job->scale = scale;
+    job->options = *options;
+    job->mesh = mesh;
+    job->texture = nullptr;
+    job->textureBytes = nullptr;
+    enqueue(job);
+}
+
+/******************************************************************
+*
+* @brief Requests a BMP texture; returns immediately. 'texture' holds
+* the placeholder until the texture is resident and must stay valid
+* until then; 'bytes' (optional) then receives its size in GPU memory.
+*
+*******************************************************************/
+void AssetLoader::loadTexture(const string &path, GLuint *texture, size_t *bytes)
+{
+    *texture = placeholderTexture;
+
+    auto *job = new AssetJob();
+    job->kind = ASSET_TEXTURE;
+    job->path = path;
+    job->scale = 1.0f;
+    job->options = DefaultMeshImportOptions;
+    job->mesh = nullptr;
+    job->texture = texture;
+    job->textureBytes = bytes;
+    enqueue(job);
+}
+
+/******************************************************************
+*
+* @brief Does one bounded piece of the GL upload of a loaded asset:
+* creating the objects, one chunk of data, or finishing it
+*
+* @return 1 once the asset is resident
+*******************************************************************/
+int AssetLoader::uploadStep(AssetJob *job)
+{
+    if (!job->success)
+    {
+        fprintf(stderr, "Could not load %s. Exiting.\n", job->path.c_str());
+        exit(-1);
+    }
+
+    if (job->kind == ASSET_MESH)
+    {
+        const MeshView &view = job->view;
+        Mesh *mesh = &job->uploading;
+        size_t vertexBytes = (size_t) view.vertexCount * view.vertexStride;
+        size_t indexBytes = (size_t) view.indexCount * view.indexSize;
+
+        if (!job->started)
+        {
+            SetupMeshParameters(job->path, &view, mesh);
+            pool->allocate(mesh, view.vertexFormat, view.vertexStride, view.vertexCount, view.indexSize,
+                           view.indexCount);
+
+            job->started = 1;
+            return 0;
+        }
+
+        if (job->uploaded < vertexBytes + indexBytes)
+        {
+            int vertices = job->uploaded < vertexBytes;
+            size_t offset = vertices ? job->uploaded : job->uploaded - vertexBytes;
+            size_t size = (vertices ? vertexBytes : indexBytes) - offset;
+            if (size > ASSET_UPLOAD_CHUNK)
+                size = ASSET_UPLOAD_CHUNK;
+
+            const char *source = (const char *) (vertices ? view.vertices : view.indices);
+            pool->upload(mesh, vertices, offset, size, source + offset);
+
+            job->uploaded += size;
+            return 0;
+        }
+
+        CloseMeshView(&job->view);
+
+        *job->mesh = *mesh;
+        return 1;
+    }
+
+    /* BMP rows are padded to four bytes, like the default unpack alignment */
+    const TextureDataPtr &image = job->image;
+    size_t rowBytes = (image.width * 3 + 3) & ~3u;
+
+    if (!job->started)
+    {
+        glGenTextures(1, &job->textureID);
+        GLState::bindTexture(GL_TEXTURE_2D, job->textureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, image.width, image.height, 0, GL_BGR, GL_UNSIGNED_BYTE, nullptr);
+
+        job->started = 1;
+        return 0;
+    }
+
+    GLState::bindTexture(GL_TEXTURE_2D, job->textureID);
+
+    if (job->uploaded < image.height)
+    {
+        size_t rows = ASSET_UPLOAD_CHUNK / rowBytes;
+        rows = rows < 1 ? 1 : rows;
+        if (rows > image.height - job->uploaded)
+            rows = image.height - job->uploaded;
+
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, job->uploaded, image.width, rows, GL_BGR, GL_UNSIGNED_BYTE,
+                        image.data + job->uploaded * rowBytes);
+
+        job->uploaded += rows;
+        return 0;
+    }
+
+    SetupTextureParameters();
+    free(job->image.data);
+
+    *job->texture = job->textureID;
+    if (job->textureBytes != nullptr)
+        *job->textureBytes = (size_t) image.width * image.height * 3 * 4 / 3;  // with MIP maps
+    return 1;
+}
+
+/******************************************************************
+*
+* @brief Uploads loaded assets for about 'budgetMs' milliseconds;
+* called once per frame from the thread that owns the GL context.
+* At least one step is done per call, so loading always progresses.
+*
+* @return number of assets that are not resident yet
+*******************************************************************/
+int AssetLoader::update(double budgetMs)
+{
+    double start = glfwGetTime();
+
+    do
+    {
+        AssetJob *job;
+        {
+            lock_guard<mutex> guard(lock);
+            if (loaded.empty())
+                break;
+            job = loaded.front();
+        }
+
+        if (uploadStep(job))
+        {
+            lock_guard<mutex> guard(lock);
+            loaded.pop_front();
+            pending--;
+            delete job;
+        }
+    } while ((glfwGetTime() - start) * 1000.0 < budgetMs);
+
+    return getPending();
+}
+
+/** Returns the number of requested assets that are not resident yet */
+int AssetLoader::getPending()
+{
+    lock_guard<mutex> guard(lock);
+    return pending;
+}
+
+/** Returns the white 1x1 texture that stands in for textures until they are resident */
+GLuint AssetLoader::getPlaceholderTexture()
+{
+    return placeholderTexture;
+}
@@ -0,0 +1,92 @@
+#ifndef ASSETLOADER_H
+#define ASSETLOADER_H
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "utils.hpp"
+#include "LoadTexture.hpp"
+
+/* Bytes handed to the driver per upload step (glBufferSubData / glTexSubImage2D) */
+#define ASSET_UPLOAD_CHUNK (256 * 1024)
+
+/* Time per frame spent on GPU uploads, in milliseconds */
+#define ASSET_UPLOAD_BUDGET_MS 2.0
+
+using namespace std;
+
+/******************************************************************
+*
+* Loads meshes and textures in the background: files are parsed and
+* decoded on worker threads, the GL uploads are done in small steps
+* by update() on the thread that owns the GL context. Until an asset
+* is resident its mesh has no levels of detail (nothing is drawn) and
+* its texture is a white 1x1 placeholder.
+*
+*******************************************************************/
+class AssetLoader
+{
+private:
+    enum AssetKind
+    {
+        ASSET_MESH, ASSET_TEXTURE
+    };
+
+    struct AssetJob
+    {
+        AssetKind kind;
+        string path;
+        float scale;
+        MeshImportOptions options;
+        Mesh *mesh;         // destination, written once the mesh is resident
+        GLuint *texture;    // destination, written once the texture is resident
+        size_t *textureBytes;
+
+        int success;
+        MeshData storage;   // streams rebuilt from the OBJ file, if not cached
+        MeshView view;
+        TextureDataPtr image;
+
+        Mesh uploading;     // pool ranges being filled
+        GLuint textureID;
+        size_t uploaded;    // bytes (mesh) or rows (texture) uploaded so far
+        int started;
+    };
+
+    vector<thread> workers;
+    mutex lock;
+    condition_variable wake;
+    deque<AssetJob *> requested;  // waiting for a worker
+    deque<AssetJob *> loaded;     // waiting for the upload, in the order they finished
+    int stopping;
+    int pending;                  // requested but not resident
+
+    GLuint placeholderTexture;
+    GeometryPool *pool;
+
+    void work();
+
+    void enqueue(AssetJob *job);
+
+    int uploadStep(AssetJob *job);
+
+public:
+    explicit AssetLoader(GeometryPool *pool, int threads = 0);
+
+    ~AssetLoader();
+
+    void loadMesh(const string &path, float scale, const MeshImportOptions *options, Mesh *mesh);
+
+    void loadTexture(const string &path, GLuint *texture, size_t *bytes = nullptr);
+
+    int update(double budgetMs);
+
+    int getPending();
+
+    GLuint getPlaceholderTexture();
+};
+
+#endif /* ASSETLOADER_H */
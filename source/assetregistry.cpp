@@ -0,0 +1,197 @@
+#include "assetregistry.hpp"
+#include "glstate.hpp"
+
+AssetRegistry::AssetRegistry(int threads) :
+        loader(&geometry, threads), hits(0), misses(0), unreferenced(0)
+{
+}
+
+/** Frees the bookkeeping and the geometry pool; needs a current GL context */
+AssetRegistry::~AssetRegistry()
+{
+    for (auto &entry : meshes)
+        delete entry.second;
+    for (auto &entry : textures)
+        delete entry.second;
+}
+
+/* Everything that changes the uploaded streams is part of a mesh's key */
+string AssetRegistry::meshKey(const string &path, float scale, const MeshImportOptions *options)
+{
+    char key[128];
+    snprintf(key, sizeof(key), "|%g|%g|%d%d%d", scale, options->weldEpsilon, options->optimize, options->quantize,
+             options->simplify);
+    return path + key;
+}
+
+/******************************************************************
+*
+* @brief Returns the shared mesh for (path, scale, options), loading
+* it in the background on the first request. The mesh has no levels
+* of detail until it is resident.
+*
+*******************************************************************/
+const Mesh *AssetRegistry::acquireMesh(const string &path, float scale, const MeshImportOptions *options)
+{
+    string key = meshKey(path, scale, options);
+
+    auto found = meshes.find(key);
+    if (found != meshes.end())
+    {
+        MeshEntry *entry = found->second;
+        if (entry->references++ == 0)
+            unreferenced--;
+        entry->acquisitions++;
+        hits++;
+        return &entry->mesh;
+    }
+
+    auto *entry = new MeshEntry();
+    entry->references = 1;
+    entry->acquisitions = 1;
+    meshes[key] = entry;
+    misses++;
+
+    loader.loadMesh(path, scale, options, &entry->mesh);
+    return &entry->mesh;
+}
+
+/** Returns the shared texture for a BMP file; it is a placeholder until resident */
+const GLuint *AssetRegistry::acquireTexture(const string &path)
+{
+    auto found = textures.find(path);
+    if (found != textures.end())
+    {
+        TextureEntry *entry = found->second;
+        if (entry->references++ == 0)
+            unreferenced--;
+        entry->acquisitions++;
+        hits++;
+        return &entry->texture;
+    }
+
+    auto *entry = new TextureEntry();
+    entry->bytes = 0;
+    entry->references = 1;
+    entry->acquisitions = 1;
+    textures[path] = entry;
+    misses++;
+
+    loader.loadTexture(path, &entry->texture, &entry->bytes);
+    return &entry->texture;
+}
+
+/** Drops a reference to a mesh from acquireMesh */
+void AssetRegistry::releaseMesh(const Mesh *mesh)
+{
+    for (auto &entry : meshes)
+    {
+        if (&entry.second->mesh == mesh)
+        {
+            if (--entry.second->references == 0)
+                unreferenced++;
+            break;
+        }
+    }
+    collect();
+}
+
+/** Drops a reference to a texture from acquireTexture */
+void AssetRegistry::releaseTexture(const GLuint *texture)
+{
+    for (auto &entry : textures)
+    {
+        if (&entry.second->texture == texture)
+        {
+            if (--entry.second->references == 0)
+                unreferenced++;
+            break;
+        }
+    }
+    collect();
+}
+
+/** Returns whether a texture from acquireTexture is loaded, i.e. no longer the placeholder */
+int AssetRegistry::isTextureResident(GLuint texture)
+{
+    return texture != loader.getPlaceholderTexture();
+}
+
+/******************************************************************
+*
+* @brief Frees the pool ranges and textures of unreferenced assets. Assets that
+* are still being loaded are kept until they are resident, because
+* the loader writes into their entries.
+*
+*******************************************************************/
+void AssetRegistry::collect()
+{
+    if (unreferenced == 0)
+        return;
+
+    for (auto entry = meshes.begin(); entry != meshes.end();)
+    {
+        Mesh &mesh = entry->second->mesh;
+        if (entry->second->references > 0 || mesh.lodCount == 0)
+        {
+            ++entry;
+            continue;
+        }
+
+        geometry.release(&mesh);
+        delete entry->second;
+        entry = meshes.erase(entry);
+        unreferenced--;
+    }
+
+    for (auto entry = textures.begin(); entry != textures.end();)
+    {
+        if (entry->second->references > 0 || entry->second->bytes == 0)
+        {
+            ++entry;
+            continue;
+        }
+
+        GLState::deleteTexture(entry->second->texture);
+        delete entry->second;
+        entry = textures.erase(entry);
+        unreferenced--;
+    }
+}
+
+/******************************************************************
+*
+* @brief Uploads loaded assets for about 'budgetMs' milliseconds
+* (see AssetLoader::update) and deletes unreferenced ones
+*
+* @return number of assets that are not resident yet
+*******************************************************************/
+int AssetRegistry::update(double budgetMs)
+{
+    int pending = loader.update(budgetMs);
+    collect();
+    return pending;
+}
+
+/** Prints hits, misses and the GPU memory that sharing saved */
+void AssetRegistry::printStatistics()
+{
+    size_t used = 0;
+    size_t saved = 0;
+
+    for (auto &entry : meshes)
+    {
+        used += entry.second->mesh.gpuBytes;
+        saved += (entry.second->acquisitions - 1) * entry.second->mesh.gpuBytes;
+    }
+    for (auto &entry : textures)
+    {
+        used += entry.second->bytes;
+        saved += (entry.second->acquisitions - 1) * entry.second->bytes;
+    }
+
+    printf("Assets: %zu meshes, %zu textures, %d hits, %d misses, %zu KB GPU memory, %zu KB saved by sharing\n",
+           meshes.size(), textures.size(), hits, misses, used / 1024, saved / 1024);
+    printf("Geometry pool: %d arenas, %zu KB used of %zu KB\n", geometry.getArenaCount(),
+           geometry.getUsedBytes() / 1024, geometry.getCapacity() / 1024);
+}
@@ -0,0 +1,72 @@
+#ifndef ASSETREGISTRY_H
+#define ASSETREGISTRY_H
+
+#include <map>
+#include <string>
+#include "assetloader.hpp"
+
+using namespace std;
+
+/******************************************************************
+*
+* Hands out shared meshes and textures: an asset that is requested
+* again with the same key - (path, scale, import options) for meshes,
+* the path for textures - gets the handle of the first request
+* instead of being loaded and uploaded once more. Handles are
+* reference counted; a mesh's pool ranges and a texture are freed
+* with the last reference.
+*
+*******************************************************************/
+class AssetRegistry
+{
+private:
+    struct MeshEntry
+    {
+        Mesh mesh;          // filled in by the loader
+        int references;
+        int acquisitions;   // all requests, including the first
+    };
+
+    struct TextureEntry
+    {
+        GLuint texture;     // placeholder until resident
+        size_t bytes;       // 0 until resident
+        int references;
+        int acquisitions;
+    };
+
+    GeometryPool geometry;  // all meshes, suballocated
+    AssetLoader loader;
+    map<string, MeshEntry *> meshes;
+    map<string, TextureEntry *> textures;
+
+    int hits;
+    int misses;
+    int unreferenced;       // entries released while still loading
+
+    static string meshKey(const string &path, float scale, const MeshImportOptions *options);
+
+    void collect();
+
+public:
+    explicit AssetRegistry(int threads = 0);
+
+    ~AssetRegistry();
+
+    const Mesh *acquireMesh(const string &path, float scale,
+                            const MeshImportOptions *options = &DefaultMeshImportOptions);
+
+    const GLuint *acquireTexture(const string &path);
+
+    void releaseMesh(const Mesh *mesh);
+
+    void releaseTexture(const GLuint *texture);
+
+    int isTextureResident(GLuint texture);
+
+    int update(double budgetMs);
+
+    void printStatistics();
+};
+
+#endif /* ASSETREGISTRY_H */
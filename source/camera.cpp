@@ -187,24 +187,20 @@ void Camera::LookAt(float *target)
     memcpy(this->viewMatrix, matrix, 16 * sizeof(float));
 }
 
-/*
- * Shoot update openGL buffers on the given program
+/**
+ * @brief Copies the current projection and view matrices for the render thread.
+ *
+ * @param uniforms The camera block of a scene snapshot.
  */
-void Camera::Shoot(GLuint program) {
-    /* Associate program with uniform shader matrices */
-    GLint projectionUniform = glGetUniformLocation(program, "ProjectionMatrix");
-    if (projectionUniform == -1)
-    {
-        fprintf(stderr, "Could not bind uniform ProjectionMatrix\n");
-        exit(-1);
-    }
-    glUniformMatrix4fv(projectionUniform, 1, GL_TRUE, projectionMatrix);
+void Camera::Snapshot(CameraUniforms *uniforms)
+{
+    memcpy(uniforms->projectionMatrix, projectionMatrix, 16 * sizeof(float));
+    memcpy(uniforms->viewMatrix, viewMatrix, 16 * sizeof(float));
+}
 
-    GLint ViewUniform = glGetUniformLocation(program, "ViewMatrix");
-    if (ViewUniform == -1)
-    {
-        fprintf(stderr, "Could not bind uniform ViewMatrix\n");
-        exit(-1);
-    }
-    glUniformMatrix4fv(ViewUniform, 1, GL_TRUE, viewMatrix);
+/*
+ * Shoot adds a snapshot's camera block to the frame, shared by all draws
+ */
+void Camera::Shoot(const CameraUniforms *uniforms, UniformBuffer *frame) {
+    frame->bind(UNIFORM_BLOCK_CAMERA, frame->append(uniforms, sizeof(CameraUniforms)), sizeof(CameraUniforms));
 }
@@ -9,6 +9,7 @@
 #include <cstdlib>
 #include "utils.hpp"
 #include "Matrix.h"
+#include "uniformbuffer.hpp"
 
 extern float winWidth;
 extern float winHeight;
@@ -44,7 +45,9 @@ public:
 
     void UpdateZoom(ScrollWheelState *state);
 
-    void Shoot(GLuint program);
+    void Snapshot(CameraUniforms *uniforms);
+
+    static void Shoot(const CameraUniforms *uniforms, UniformBuffer *frame);
 
     float projectionMatrix[16];
     float viewMatrix[16];
@@ -0,0 +1,96 @@
+#include <cstring>
+#include "clusterbuffers.hpp"
+#include <GLFW/glfw3.h>
+#include "glstate.hpp"
+#include "shaderprogram.hpp"
+
+/* Texel formats of the three views and their sizes in bytes */
+static const GLenum textureFormats[3] = {GL_RGBA32F, GL_RG32UI, GL_R16UI};
+static const GLenum textureUnits[3] = {TEXTURE_UNIT_CLUSTER_LIGHTS, TEXTURE_UNIT_CLUSTER_RANGES,
+                                       TEXTURE_UNIT_CLUSTER_INDICES};
+static const size_t texelSizes[3] = {4 * sizeof(float), sizeof(ClusterRange), sizeof(uint16_t)};
+
+/** Creates the ring and its buffer textures; needs a current GL context */
+ClusterBuffers::ClusterBuffers() :
+        attached(0), buildTime(0)
+{
+    /* a region starts at a multiple of a light, so every part starts at a multiple of its texel */
+    ring = new StreamBuffer(CLUSTER_BUFFERS_FRAME_BYTES, sizeof(ClusterLight));
+    glGenTextures(3, textures);
+
+    printf("Clustered lighting: %d x %d x %d clusters, binned on %d threads\n", LIGHT_CLUSTER_X, LIGHT_CLUSTER_Y,
+           LIGHT_CLUSTER_Z, clusterer.getThreads());
+}
+
+ClusterBuffers::~ClusterBuffers()
+{
+    for (GLuint texture : textures)
+        GLState::deleteTexture(texture);
+    delete ring;
+}
+
+/******************************************************************
+*
+* @brief Bins the lights of a snapshot for its camera, uploads the
+* lists of the frame, binds the buffer textures to their units and
+* adds the ClusterBlock to the frame's uniform data. Nothing is
+* uploaded if no light reaches the view frustum; the frame is drawn
+* without the CLUSTERED_LIGHTS variants then.
+*
+*******************************************************************/
+void ClusterBuffers::update(const vector<PointLight> &lights, const CameraUniforms *camera, UniformBuffer *frame)
+{
+    double start = glfwGetTime();
+    clusterer.build(lights.data(), lights.size(), camera->viewMatrix, camera->projectionMatrix, &clusters);
+    buildTime = (glfwGetTime() - start) * 1000.0;
+    if (clusters.lights.empty())
+        return;
+
+    size_t sizes[3] = {clusters.lights.size() * sizeof(ClusterLight), clusters.ranges.size() * sizeof(ClusterRange),
+                       clusters.indices.size() * sizeof(uint16_t)};
+    const void *parts[3] = {clusters.lights.data(), clusters.ranges.data(), clusters.indices.data()};
+
+    unsigned char *data = (unsigned char *) ring->map(sizes[0] + sizes[1] + sizes[2]);
+    ClusterUniforms uniforms = {{clusters.grid.nearPlane, clusters.grid.sliceScale, 0, 0},
+                                {LIGHT_CLUSTER_X, LIGHT_CLUSTER_Y, LIGHT_CLUSTER_Z, (int32_t) clusters.lights.size()},
+                                {0, 0, 0, 0}};
+    size_t offset = 0;
+    for (int t = 0; t < 3; t++)
+    {
+        memcpy(data + offset, parts[t], sizes[t]);
+        uniforms.offsets[t] = (ring->getOffset() + offset) / texelSizes[t];
+        offset += sizes[t];
+    }
+    ring->unmap();
+
+    /* the views follow the ring when it grows into a new buffer */
+    int reattach = ring->getBuffer() != attached;
+    for (int t = 0; t < 3; t++)
+    {
+        GLState::activeTexture(GL_TEXTURE0 + textureUnits[t]);
+        GLState::bindTexture(GL_TEXTURE_BUFFER, textures[t]);
+        if (reattach)
+            glTexBuffer(GL_TEXTURE_BUFFER, textureFormats[t], ring->getBuffer());
+    }
+    attached = ring->getBuffer();
+
+    frame->bind(UNIFORM_BLOCK_CLUSTERS, frame->append(&uniforms, sizeof(uniforms)), sizeof(uniforms));
+}
+
+/** Returns the lights of the last update() that reach the view frustum */
+int ClusterBuffers::getLights()
+{
+    return clusters.lights.size();
+}
+
+/** Returns the light indices of all clusters of the last update() */
+int ClusterBuffers::getIndices()
+{
+    return clusters.indices.size();
+}
+
+/** Returns the time the last update() spent binning, in milliseconds */
+double ClusterBuffers::getBuildTime()
+{
+    return buildTime;
+}
@@ -0,0 +1,51 @@
+#ifndef CLUSTERBUFFERS_H
+#define CLUSTERBUFFERS_H
+
+#include <vector>
+#include <GL/glew.h>
+#include "LightClustering.hpp"
+#include "streambuffer.hpp"
+#include "uniformbuffer.hpp"
+
+using namespace std;
+
+/* Initial size of a frame's light lists; the ring grows when a frame needs more */
+#define CLUSTER_BUFFERS_FRAME_BYTES (64 * 1024)
+
+/******************************************************************
+*
+* Point lights for clustered forward shading. Every frame the lights
+* are binned into the clusters of the camera (see LightClusterer),
+* and the visible lights, the range of each cluster and the light
+* indices are written one after another into the next region of a
+* streaming ring. Three buffer textures view that ring as RGBA32F,
+* RG32UI and R16UI texels; the ClusterBlock tells the fragment shader
+* where the frame's data starts in each of them.
+*
+*******************************************************************/
+class ClusterBuffers
+{
+private:
+    LightClusterer clusterer;
+    LightClusters clusters;
+
+    StreamBuffer *ring;
+    GLuint textures[3];         // lights, ranges, indices
+    GLuint attached;            // buffer of the ring the textures view
+    double buildTime;           // in ms
+
+public:
+    ClusterBuffers();
+
+    ~ClusterBuffers();
+
+    void update(const vector<PointLight> &lights, const CameraUniforms *camera, UniformBuffer *frame);
+
+    int getLights();
+
+    int getIndices();
+
+    double getBuildTime();
+};
+
+#endif /* CLUSTERBUFFERS_H */
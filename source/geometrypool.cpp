@@ -0,0 +1,220 @@
+#include "geometrypool.hpp"
+#include "utils.hpp"
+#include "glstate.hpp"
+
+GeometryPool::GeometryPool() :
+        usedBytes(0), allocations(0)
+{
+}
+
+/** Deletes the buffers of all arenas; needs a current GL context */
+GeometryPool::~GeometryPool()
+{
+    for (Arena *arena : arenas)
+    {
+        GLState::deleteVertexArray(arena->VAO);
+        GLState::deleteBuffer(arena->VBO);
+        GLState::deleteBuffer(arena->IBO);
+        delete arena;
+    }
+}
+
+/* Returns the arena for a vertex format and index size, creating it on first use */
+int GeometryPool::findArena(uint32_t vertexFormat, GLsizei stride, uint32_t indexSize)
+{
+    for (size_t a = 0; a < arenas.size(); a++)
+    {
+        if (arenas[a]->vertexFormat == vertexFormat && arenas[a]->indexSize == indexSize)
+            return a;
+    }
+
+    auto *arena = new Arena();
+    arena->vertexFormat = vertexFormat;
+    arena->stride = stride;
+    arena->indexSize = indexSize;
+
+    /* capacities stay multiples of a vertex and an index, and so do all ranges */
+    arena->vertexCapacity = GEOMETRY_POOL_VERTEX_BYTES / stride * stride;
+    arena->indexCapacity = GEOMETRY_POOL_INDEX_BYTES / indexSize * indexSize;
+    arena->freeVertices.push_back({0, arena->vertexCapacity});
+    arena->freeIndices.push_back({0, arena->indexCapacity});
+
+    glGenBuffers(1, &arena->VBO);
+    GLState::bindBuffer(GL_COPY_WRITE_BUFFER, arena->VBO);
+    glBufferData(GL_COPY_WRITE_BUFFER, arena->vertexCapacity, nullptr, GL_STATIC_DRAW);
+    glGenBuffers(1, &arena->IBO);
+    GLState::bindBuffer(GL_COPY_WRITE_BUFFER, arena->IBO);
+    glBufferData(GL_COPY_WRITE_BUFFER, arena->indexCapacity, nullptr, GL_STATIC_DRAW);
+
+    glGenVertexArrays(1, &arena->VAO);
+    setupVertexArray(arena);
+
+    arenas.push_back(arena);
+    return arenas.size() - 1;
+}
+
+/* First fit; returns SIZE_MAX if no free range is large enough */
+size_t GeometryPool::take(vector<Range> *ranges, size_t size)
+{
+    if (size == 0)
+        return 0;
+
+    for (size_t i = 0; i < ranges->size(); i++)
+    {
+        Range &range = (*ranges)[i];
+        if (range.size < size)
+            continue;
+
+        size_t offset = range.offset;
+        range.offset += size;
+        range.size -= size;
+        if (range.size == 0)
+            ranges->erase(ranges->begin() + i);
+        return offset;
+    }
+    return SIZE_MAX;
+}
+
+/* Returns a range to the free list, merging it with its neighbors */
+void GeometryPool::give(vector<Range> *ranges, size_t offset, size_t size)
+{
+    if (size == 0)
+        return;
+
+    size_t i = 0;
+    while (i < ranges->size() && (*ranges)[i].offset < offset)
+        i++;
+    ranges->insert(ranges->begin() + i, {offset, size});
+
+    if (i + 1 < ranges->size() && offset + size == (*ranges)[i + 1].offset)
+    {
+        (*ranges)[i].size += (*ranges)[i + 1].size;
+        ranges->erase(ranges->begin() + i + 1);
+    }
+    if (i > 0 && (*ranges)[i - 1].offset + (*ranges)[i - 1].size == offset)
+    {
+        (*ranges)[i - 1].size += (*ranges)[i].size;
+        ranges->erase(ranges->begin() + i);
+    }
+}
+
+/******************************************************************
+*
+* @brief Replaces a full buffer with one at least twice as large that
+* can hold another 'needed' bytes; the content is copied on the GPU
+* and ranges handed out so far keep their offsets
+*
+*******************************************************************/
+void GeometryPool::grow(GLuint *buffer, size_t *capacity, size_t needed, vector<Range> *ranges)
+{
+    size_t grown = *capacity * 2 > *capacity + needed ? *capacity * 2 : *capacity + needed;
+
+    GLuint replacement;
+    glGenBuffers(1, &replacement);
+    GLState::bindBuffer(GL_COPY_WRITE_BUFFER, replacement);
+    glBufferData(GL_COPY_WRITE_BUFFER, grown, nullptr, GL_STATIC_DRAW);
+    GLState::bindBuffer(GL_COPY_READ_BUFFER, *buffer);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, *capacity);
+    GLState::deleteBuffer(*buffer);
+
+    give(ranges, *capacity, grown - *capacity);
+    *buffer = replacement;
+    *capacity = grown;
+}
+
+/* Points the arena's VAO at its current buffers */
+void GeometryPool::setupVertexArray(const Arena *arena)
+{
+    SetupMeshVertexArray(arena->VAO, arena->VBO, arena->IBO, arena->vertexFormat, arena->stride);
+}
+
+/******************************************************************
+*
+* @brief Reserves the vertex and index ranges of a mesh in the arena
+* of its format and fills in the mesh's VAO, arena, base vertex and
+* first index; the data follows with upload()
+*
+*******************************************************************/
+void GeometryPool::allocate(Mesh *mesh, uint32_t vertexFormat, GLsizei stride, uint32_t vertexCount,
+                            uint32_t indexSize, uint32_t indexCount)
+{
+    int a = findArena(vertexFormat, stride, indexSize);
+    Arena *arena = arenas[a];
+    size_t vertexBytes = (size_t) vertexCount * stride;
+    size_t indexBytes = (size_t) indexCount * indexSize;
+
+    size_t vertexOffset = take(&arena->freeVertices, vertexBytes);
+    if (vertexOffset == SIZE_MAX)
+    {
+        grow(&arena->VBO, &arena->vertexCapacity, vertexBytes, &arena->freeVertices);
+        setupVertexArray(arena);
+        vertexOffset = take(&arena->freeVertices, vertexBytes);
+    }
+
+    size_t indexOffset = take(&arena->freeIndices, indexBytes);
+    if (indexOffset == SIZE_MAX)
+    {
+        grow(&arena->IBO, &arena->indexCapacity, indexBytes, &arena->freeIndices);
+        setupVertexArray(arena);
+        indexOffset = take(&arena->freeIndices, indexBytes);
+    }
+
+    mesh->VAO = arena->VAO;
+    mesh->arena = a;
+    mesh->baseVertex = vertexOffset / stride;
+    mesh->firstIndex = indexOffset / indexSize;
+    mesh->vertexCount = vertexCount;
+    mesh->indexCount = indexCount;
+    mesh->sortId = ++allocations;
+    usedBytes += vertexBytes + indexBytes;
+}
+
+/******************************************************************
+*
+* @brief Copies part of a mesh's vertices or indices into its ranges
+*
+* @param vertices = 1 for the vertex range, 0 for the index range
+* @param offset = byte offset within the range
+*******************************************************************/
+void GeometryPool::upload(const Mesh *mesh, int vertices, size_t offset, size_t size, const void *data)
+{
+    const Arena *arena = arenas[mesh->arena];
+    size_t base = vertices ? (size_t) mesh->baseVertex * arena->stride : (size_t) mesh->firstIndex * arena->indexSize;
+
+    /* the copy target leaves the VAO and array buffer bindings alone */
+    GLState::bindBuffer(GL_COPY_WRITE_BUFFER, vertices ? arena->VBO : arena->IBO);
+    glBufferSubData(GL_COPY_WRITE_BUFFER, base + offset, size, data);
+}
+
+/** Returns the ranges of a mesh to its arena */
+void GeometryPool::release(Mesh *mesh)
+{
+    Arena *arena = arenas[mesh->arena];
+    size_t vertexBytes = (size_t) mesh->vertexCount * arena->stride;
+    size_t indexBytes = (size_t) mesh->indexCount * arena->indexSize;
+
+    give(&arena->freeVertices, (size_t) mesh->baseVertex * arena->stride, vertexBytes);
+    give(&arena->freeIndices, (size_t) mesh->firstIndex * arena->indexSize, indexBytes);
+    usedBytes -= vertexBytes + indexBytes;
+    mesh->lodCount = 0;
+}
+
+int GeometryPool::getArenaCount()
+{
+    return arenas.size();
+}
+
+/** Returns the bytes of all vertex and index ranges in use */
+size_t GeometryPool::getUsedBytes()
+{
+    return usedBytes;
+}
+
+/** Returns the size of all arena buffers in bytes */
+size_t GeometryPool::getCapacity()
+{
+    size_t capacity = 0;
+    for (const Arena *arena : arenas)
+        capacity += arena->vertexCapacity + arena->indexCapacity;
+    return capacity;
+}
@@ -0,0 +1,82 @@
+#ifndef GEOMETRYPOOL_H
+#define GEOMETRYPOOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <GL/glew.h>
+
+using namespace std;
+
+/* Initial size of an arena's vertex and index buffer; arenas double when full */
+#define GEOMETRY_POOL_VERTEX_BYTES (4 * 1024 * 1024)
+#define GEOMETRY_POOL_INDEX_BYTES (2 * 1024 * 1024)
+
+struct Mesh;
+
+/******************************************************************
+*
+* Suballocates all meshes into a few large buffers: one arena (VAO,
+* vertex buffer and index buffer) per vertex format and index size.
+* A mesh is a range of vertices and a range of indices in its arena,
+* drawn with a base vertex, so every mesh of an arena shares one VAO
+* and can be drawn by the same multi-draw call.
+*
+*******************************************************************/
+class GeometryPool
+{
+private:
+    typedef struct
+    {
+        size_t offset;
+        size_t size;
+    } Range;
+
+    typedef struct
+    {
+        uint32_t vertexFormat;
+        GLsizei stride;
+        uint32_t indexSize;
+        GLuint VAO;
+        GLuint VBO;
+        GLuint IBO;
+        size_t vertexCapacity;
+        size_t indexCapacity;
+        vector<Range> freeVertices;  // sorted by offset, adjacent ranges merged
+        vector<Range> freeIndices;
+    } Arena;
+
+    vector<Arena *> arenas;
+    size_t usedBytes;
+    uint16_t allocations;       // numbers the meshes for sort keys
+
+    int findArena(uint32_t vertexFormat, GLsizei stride, uint32_t indexSize);
+
+    static size_t take(vector<Range> *ranges, size_t size);
+
+    static void give(vector<Range> *ranges, size_t offset, size_t size);
+
+    static void grow(GLuint *buffer, size_t *capacity, size_t needed, vector<Range> *ranges);
+
+    static void setupVertexArray(const Arena *arena);
+
+public:
+    GeometryPool();
+
+    ~GeometryPool();
+
+    void allocate(Mesh *mesh, uint32_t vertexFormat, GLsizei stride, uint32_t vertexCount, uint32_t indexSize,
+                  uint32_t indexCount);
+
+    void upload(const Mesh *mesh, int vertices, size_t offset, size_t size, const void *data);
+
+    void release(Mesh *mesh);
+
+    int getArenaCount();
+
+    size_t getUsedBytes();
+
+    size_t getCapacity();
+};
+
+#endif /* GEOMETRYPOOL_H */
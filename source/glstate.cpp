@@ -0,0 +1,216 @@
+#include <initializer_list>
+#include "glstate.hpp"
+
+/* The GL defaults; polygon mode and depth function start unknown so
+ * that the first call is always issued */
+GLuint GLState::program = 0;
+GLuint GLState::vertexArray = 0;
+GLuint GLState::arrayBuffer = 0;
+GLuint GLState::uniformBuffer = 0;
+GLuint GLState::copyReadBuffer = 0;
+GLuint GLState::copyWriteBuffer = 0;
+GLuint GLState::drawIndirectBuffer = 0;
+GLenum GLState::activeUnit = GL_TEXTURE0;
+GLuint GLState::textures[GLSTATE_TEXTURE_UNITS] = {0};
+GLenum GLState::polygonMode = GL_NONE;
+int GLState::depthTest = 0;
+GLenum GLState::depthFunc = GL_NONE;
+GLState::BufferRange GLState::uniformRanges[GLSTATE_UNIFORM_BINDINGS] = {};
+GLStateCounters GLState::counters = {0, 0};
+
+/* Returns the shadow of a buffer binding point, or nullptr if it is not tracked */
+GLuint *GLState::bufferBinding(GLenum target)
+{
+    switch (target)
+    {
+        case GL_ARRAY_BUFFER:
+            return &arrayBuffer;
+        case GL_UNIFORM_BUFFER:
+            return &uniformBuffer;
+        case GL_COPY_READ_BUFFER:
+            return &copyReadBuffer;
+        case GL_COPY_WRITE_BUFFER:
+            return &copyWriteBuffer;
+        case GL_DRAW_INDIRECT_BUFFER:
+            return &drawIndirectBuffer;
+        default:
+            return nullptr;
+    }
+}
+
+/* Counts a call; returns 'change', i.e. whether it has to be issued */
+int GLState::changed(int change)
+{
+    if (change)
+        counters.issued++;
+    else
+        counters.elided++;
+    return change;
+}
+
+void GLState::useProgram(GLuint _program)
+{
+    if (changed(program != _program))
+    {
+        glUseProgram(_program);
+        program = _program;
+    }
+}
+
+void GLState::bindVertexArray(GLuint _vertexArray)
+{
+    if (changed(vertexArray != _vertexArray))
+    {
+        glBindVertexArray(_vertexArray);
+        vertexArray = _vertexArray;
+    }
+}
+
+/* GL_ELEMENT_ARRAY_BUFFER belongs to the bound VAO and is not tracked */
+void GLState::bindBuffer(GLenum target, GLuint buffer)
+{
+    GLuint *binding = bufferBinding(target);
+    if (binding == nullptr)
+    {
+        changed(1);
+        glBindBuffer(target, buffer);
+        return;
+    }
+
+    if (changed(*binding != buffer))
+    {
+        glBindBuffer(target, buffer);
+        *binding = buffer;
+    }
+}
+
+/* Binds a range to an indexed binding point; like GL this also binds the generic target */
+void GLState::bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size)
+{
+    if (target != GL_UNIFORM_BUFFER || index >= GLSTATE_UNIFORM_BINDINGS)
+    {
+        changed(1);
+        glBindBufferRange(target, index, buffer, offset, size);
+        GLuint *binding = bufferBinding(target);
+        if (binding != nullptr)
+            *binding = buffer;
+        return;
+    }
+
+    BufferRange &range = uniformRanges[index];
+    if (changed(range.buffer != buffer || range.offset != offset || range.size != size))
+    {
+        glBindBufferRange(target, index, buffer, offset, size);
+        range = {buffer, offset, size};
+        uniformBuffer = buffer;
+    }
+}
+
+void GLState::activeTexture(GLenum unit)
+{
+    if (changed(activeUnit != unit))
+    {
+        glActiveTexture(unit);
+        activeUnit = unit;
+    }
+}
+
+/* Only GL_TEXTURE_2D on the first GLSTATE_TEXTURE_UNITS units is tracked */
+void GLState::bindTexture(GLenum target, GLuint texture)
+{
+    GLuint unit = activeUnit - GL_TEXTURE0;
+    if (target != GL_TEXTURE_2D || unit >= GLSTATE_TEXTURE_UNITS)
+    {
+        changed(1);
+        glBindTexture(target, texture);
+        return;
+    }
+
+    if (changed(textures[unit] != texture))
+    {
+        glBindTexture(target, texture);
+        textures[unit] = texture;
+    }
+}
+
+void GLState::setPolygonMode(GLenum mode)
+{
+    if (changed(polygonMode != mode))
+    {
+        glPolygonMode(GL_FRONT_AND_BACK, mode);
+        polygonMode = mode;
+    }
+}
+
+void GLState::setDepthTest(int enabled)
+{
+    if (changed(depthTest != enabled))
+    {
+        if (enabled)
+            glEnable(GL_DEPTH_TEST);
+        else
+            glDisable(GL_DEPTH_TEST);
+        depthTest = enabled;
+    }
+}
+
+void GLState::setDepthFunc(GLenum func)
+{
+    if (changed(depthFunc != func))
+    {
+        glDepthFunc(func);
+        depthFunc = func;
+    }
+}
+
+/* Deleting a bound buffer, VAO or texture unbinds it in GL, and so in the shadow copy; a
+ * deleted program stays in use until another one is, so it is unbound here explicitly */
+void GLState::deleteProgram(GLuint _program)
+{
+    if (program == _program)
+    {
+        glUseProgram(0);
+        program = 0;
+    }
+    glDeleteProgram(_program);
+}
+
+void GLState::deleteVertexArray(GLuint _vertexArray)
+{
+    if (vertexArray == _vertexArray)
+        vertexArray = 0;
+    glDeleteVertexArrays(1, &_vertexArray);
+}
+
+void GLState::deleteBuffer(GLuint buffer)
+{
+    for (GLuint *binding : {&arrayBuffer, &uniformBuffer, &copyReadBuffer, &copyWriteBuffer, &drawIndirectBuffer})
+    {
+        if (*binding == buffer)
+            *binding = 0;
+    }
+    for (BufferRange &range : uniformRanges)
+    {
+        if (range.buffer == buffer)
+            range = {0, 0, 0};
+    }
+    glDeleteBuffers(1, &buffer);
+}
+
+void GLState::deleteTexture(GLuint texture)
+{
+    for (GLuint &bound : textures)
+    {
+        if (bound == texture)
+            bound = 0;
+    }
+    glDeleteTextures(1, &texture);
+}
+
+/** Returns the counts since the last call and starts new ones; called once per frame */
+GLStateCounters GLState::resetCounters()
+{
+    GLStateCounters result = counters;
+    counters = {0, 0};
+    return result;
+}
@@ -0,0 +1,88 @@
+#ifndef GLSTATE_H
+#define GLSTATE_H
+
+#include <GL/glew.h>
+
+/* Texture units and indexed uniform buffer bindings that are tracked */
+#define GLSTATE_TEXTURE_UNITS 8
+#define GLSTATE_UNIFORM_BINDINGS 8
+
+/* Calls issued to the driver and calls skipped because they would not change anything */
+typedef struct
+{
+    int issued;
+    int elided;
+} GLStateCounters;
+
+/******************************************************************
+*
+* Shadows the GL state the renderer changes - program, VAO, buffer
+* bindings, textures, active texture unit, polygon mode and depth
+* state - and skips calls that would set what is already set. All
+* code that changes this state must go through GLState, otherwise
+* the shadow copy goes stale; objects must be deleted through it, as
+* their names can be reused.
+*
+*******************************************************************/
+class GLState
+{
+private:
+    static GLuint program;
+    static GLuint vertexArray;
+    static GLuint arrayBuffer;
+    static GLuint uniformBuffer;
+    static GLuint copyReadBuffer;
+    static GLuint copyWriteBuffer;
+    static GLuint drawIndirectBuffer;
+    static GLenum activeUnit;
+    static GLuint textures[GLSTATE_TEXTURE_UNITS];
+    static GLenum polygonMode;
+    static int depthTest;
+    static GLenum depthFunc;
+
+    typedef struct
+    {
+        GLuint buffer;
+        GLintptr offset;
+        GLsizeiptr size;
+    } BufferRange;
+
+    static BufferRange uniformRanges[GLSTATE_UNIFORM_BINDINGS];
+
+    static GLStateCounters counters;
+
+    static GLuint *bufferBinding(GLenum target);
+
+    static int changed(int change);
+
+public:
+    static void useProgram(GLuint program);
+
+    static void bindVertexArray(GLuint vertexArray);
+
+    static void bindBuffer(GLenum target, GLuint buffer);
+
+    static void bindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+
+    static void activeTexture(GLenum unit);
+
+    static void bindTexture(GLenum target, GLuint texture);
+
+    static void setPolygonMode(GLenum mode);
+
+    static void setDepthTest(int enabled);
+
+    static void setDepthFunc(GLenum func);
+
+    static void deleteProgram(GLuint program);
+
+    static void deleteVertexArray(GLuint vertexArray);
+
+    static void deleteBuffer(GLuint buffer);
+
+    static void deleteTexture(GLuint texture);
+
+    static GLStateCounters resetCounters();
+};
+
+#endif /* GLSTATE_H */
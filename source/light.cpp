@@ -206,31 +206,31 @@ void Light::LightDown(KeyboardState* keyboard)
 }
 
 /**
- * @brief Updates the shader of the current program with the current light settings.
+ * @brief Copies the current light settings for the render thread.
  *
- * @param shaderProgram The shader of the current program.
+ * @param uniforms The light block of a scene snapshot.
  */
-void Light::LightUpScene(GLuint shaderProgram)
+void Light::Snapshot(LightUniforms *uniforms)
 {
-    BindUniform1f("AmbientFactor", shaderProgram, this->settings.ambient);
-    BindUniform1f("DiffuseFactor", shaderProgram, this->settings.diffuse);
-    BindUniform1f("SpecularFactor", shaderProgram, this->settings.specular);
-
-    int size = BindBasics(this->VBO, this->CBO, this->IBO, 0, 0);
-
-    // create light position matrix and resize
-    float pos[16];
-    SetTranslation(this->position.x, this->position.y, this->position.z, pos);
-
-    float scale[16];
-    SetScaleMatrix(.1, .1, .1, scale);
-    MultiplyMatrix(pos, scale, pos);
-    BindUniform4f("Transform", shaderProgram, pos);
-
-    BindUniform3f("Color", shaderProgram, this->color);
-
-    glDrawElements(GL_TRIANGLES, size, GL_UNSIGNED_INT, 0);
+    *uniforms = {
+        {this->position.x, this->position.y, this->position.z, 1.0f},
+        {this->color.x, this->color.y, this->color.z, 1.0f},
+        this->settings.ambient,
+        this->settings.diffuse,
+        this->settings.specular,
+        0.0f
+    };
+}
 
-    BindUniform3f("light.position", shaderProgram, this->position);
-    BindUniform3f("light.color", shaderProgram, this->color);
+/**
+ * @brief Adds a snapshot's light settings to the frame's uniform block data.
+ * Nothing is read from a Light object, so the simulation may update it meanwhile;
+ * the light's gizmo is drawn by LightGizmos.
+ *
+ * @param uniforms The light block of the snapshot that is drawn.
+ * @param frame The uniform block data of the current frame.
+ */
+void Light::LightUpScene(const LightUniforms *uniforms, UniformBuffer *frame)
+{
+    frame->bind(UNIFORM_BLOCK_LIGHT, frame->append(uniforms, sizeof(LightUniforms)), sizeof(LightUniforms));
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "lightsetting.hpp"
 #include "utils.hpp"
 #include "Matrix.h"
+#include "uniformbuffer.hpp"
 
 #include <iostream>
 
@@ -20,9 +21,6 @@ class Light
         void LightDown(KeyboardState* keyboard);
         void MoveLight(KeyboardState* keyboard);
         void ChangeColor(KeyboardState* keyboard);
-        GLuint VBO;
-        GLuint CBO;
-        GLuint IBO;
         int colorCounter;
         Vector position;
         Vector color;
@@ -31,7 +29,8 @@ class Light
         LightSettings settings;
         Light(LightSettings settings, Vector position, Vector color);
         void Update(KeyboardState* keyboard);
-        void LightUpScene(GLuint shaderProgram);        
+        void Snapshot(LightUniforms *uniforms);
+        static void LightUpScene(const LightUniforms *uniforms, UniformBuffer *frame);
         void Reset();
 };
 
@@ -0,0 +1,166 @@
+#include <cmath>
+#include <cstring>
+#include <map>
+#include "lightgizmos.hpp"
+#include "glstate.hpp"
+#include "utils.hpp"
+
+/* Corners and faces of an icosahedron, counterclockwise from outside */
+static const float icosahedronGolden = 1.6180340f;
+
+static const float icosahedronCorners[12][3] = {
+    {-1, icosahedronGolden, 0}, {1, icosahedronGolden, 0}, {-1, -icosahedronGolden, 0}, {1, -icosahedronGolden, 0},
+    {0, -1, icosahedronGolden}, {0, 1, icosahedronGolden}, {0, -1, -icosahedronGolden}, {0, 1, -icosahedronGolden},
+    {icosahedronGolden, 0, -1}, {icosahedronGolden, 0, 1}, {-icosahedronGolden, 0, -1}, {-icosahedronGolden, 0, 1}
+};
+
+static const GLushort icosahedronFaces[20][3] = {
+    {0, 11, 5}, {0, 5, 1}, {0, 1, 7}, {0, 7, 10}, {0, 10, 11},
+    {1, 5, 9}, {5, 11, 4}, {11, 10, 2}, {10, 7, 6}, {7, 1, 8},
+    {3, 9, 4}, {3, 4, 2}, {3, 2, 6}, {3, 6, 8}, {3, 8, 9},
+    {4, 9, 5}, {2, 4, 11}, {6, 2, 10}, {8, 6, 7}, {9, 8, 1}
+};
+
+/* Appends a point of the unit sphere and returns its index */
+static GLushort addSpherePoint(vector<float> *positions, float x, float y, float z)
+{
+    float length = sqrtf(x * x + y * y + z * z);
+    positions->push_back(x / length);
+    positions->push_back(y / length);
+    positions->push_back(z / length);
+    return positions->size() / 3 - 1;
+}
+
+/******************************************************************
+*
+* @brief Builds a unit icosphere: every subdivision splits each
+* triangle into four at the midpoints of its edges, which are moved
+* onto the sphere. Edges shared by two triangles share the midpoint.
+*
+*******************************************************************/
+void LightGizmos::buildIcosphere(int subdivisions, vector<float> *positions, vector<GLushort> *indices)
+{
+    positions->clear();
+    for (const float *corner : icosahedronCorners)
+        addSpherePoint(positions, corner[0], corner[1], corner[2]);
+    indices->assign(&icosahedronFaces[0][0], &icosahedronFaces[0][0] + 20 * 3);
+
+    for (int s = 0; s < subdivisions; s++)
+    {
+        map<uint32_t, GLushort> midpoints;     // by the indices of the edge, smaller one first
+        vector<GLushort> split;
+        for (size_t t = 0; t < indices->size(); t += 3)
+        {
+            GLushort middle[3];
+            for (int e = 0; e < 3; e++)
+            {
+                GLushort a = (*indices)[t + e];
+                GLushort b = (*indices)[t + (e + 1) % 3];
+                uint32_t edge = a < b ? (uint32_t) a << 16 | b : (uint32_t) b << 16 | a;
+                auto found = midpoints.find(edge);
+                if (found == midpoints.end())
+                {
+                    const float *pa = &(*positions)[a * 3];
+                    const float *pb = &(*positions)[b * 3];
+                    GLushort point = addSpherePoint(positions, pa[0] + pb[0], pa[1] + pb[1], pa[2] + pb[2]);
+                    found = midpoints.insert({edge, point}).first;
+                }
+                middle[e] = found->second;
+            }
+
+            GLushort corners[3] = {(*indices)[t], (*indices)[t + 1], (*indices)[t + 2]};
+            split.insert(split.end(), {corners[0], middle[0], middle[2]});
+            split.insert(split.end(), {corners[1], middle[1], middle[0]});
+            split.insert(split.end(), {corners[2], middle[2], middle[1]});
+            split.insert(split.end(), {middle[0], middle[1], middle[2]});
+        }
+        indices->swap(split);
+    }
+}
+
+/** Builds the gizmo program and uploads the icosphere; needs a current GL context */
+LightGizmos::LightGizmos()
+{
+    programs = new ShaderVariants("../shaders/gizmo.vs", "../shaders/gizmo.fs", 0);
+
+    vector<float> positions;
+    vector<GLushort> indices;
+    buildIcosphere(LIGHT_GIZMO_SUBDIVISIONS, &positions, &indices);
+    indexCount = indices.size();
+
+    glGenBuffers(1, &VBO);
+    GLState::bindBuffer(GL_ARRAY_BUFFER, VBO);
+    glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(float), positions.data(), GL_STATIC_DRAW);
+    glGenBuffers(1, &IBO);
+    GLState::bindBuffer(GL_COPY_WRITE_BUFFER, IBO);
+    glBufferData(GL_COPY_WRITE_BUFFER, indices.size() * sizeof(GLushort), indices.data(), GL_STATIC_DRAW);
+
+    instanceRing = new StreamBuffer(LIGHT_GIZMO_INSTANCE_BYTES, sizeof(GizmoInstance));
+
+    glGenVertexArrays(1, &VAO);
+    GLState::bindVertexArray(VAO);
+    glEnableVertexAttribArray(vPosition);
+    glVertexAttribPointer(vPosition, 3, GL_FLOAT, GL_FALSE, 0, 0);
+
+    /* Position and color of the light, advanced per instance; the pointers follow the ring in draw() */
+    for (int attribute = vInstance; attribute <= vInstance + 1; attribute++)
+    {
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribDivisor(attribute, 1);
+    }
+
+    /* Bind index buffer */
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
+
+    GLState::bindVertexArray(0);
+}
+
+LightGizmos::~LightGizmos()
+{
+    GLState::deleteVertexArray(VAO);
+    GLState::deleteBuffer(VBO);
+    GLState::deleteBuffer(IBO);
+    delete instanceRing;
+    delete programs;
+}
+
+/******************************************************************
+*
+* @brief Draws the gizmos of the adjustable light and of all point
+* lights of a snapshot in one instanced call; the CameraBlock of the
+* frame must be bound
+*
+*******************************************************************/
+void LightGizmos::draw(const LightUniforms *light, const vector<PointLight> &lights)
+{
+    instances.clear();
+    instances.push_back({{light->position[0], light->position[1], light->position[2], LIGHT_GIZMO_SIZE},
+                         {light->color[0], light->color[1], light->color[2], 1.0f}});
+    for (const PointLight &point : lights)
+    {
+        instances.push_back({{point.position[0], point.position[1], point.position[2], POINT_LIGHT_GIZMO_SIZE},
+                             {point.color[0], point.color[1], point.color[2], 1.0f}});
+    }
+
+    size_t size = instances.size() * sizeof(GizmoInstance);
+    memcpy(instanceRing->map(size), instances.data(), size);
+    instanceRing->unmap();
+
+    programs->select(0)->use();
+    GLState::bindVertexArray(VAO);
+
+    size_t base = instanceRing->getOffset();
+    GLState::bindBuffer(GL_ARRAY_BUFFER, instanceRing->getBuffer());
+    glVertexAttribPointer(vInstance, 4, GL_FLOAT, GL_FALSE, sizeof(GizmoInstance),
+                          (void *) (base + offsetof(GizmoInstance, position)));
+    glVertexAttribPointer(vInstance + 1, 4, GL_FLOAT, GL_FALSE, sizeof(GizmoInstance),
+                          (void *) (base + offsetof(GizmoInstance, color)));
+
+    glDrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_SHORT, 0, instances.size());
+}
+
+/** Returns the gizmos of the last draw() */
+int LightGizmos::getInstances()
+{
+    return instances.size();
+}
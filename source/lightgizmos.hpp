@@ -0,0 +1,63 @@
+#ifndef LIGHTGIZMOS_H
+#define LIGHTGIZMOS_H
+
+#include <vector>
+#include <GL/glew.h>
+#include "LightClustering.hpp"
+#include "shadervariants.hpp"
+#include "streambuffer.hpp"
+#include "uniformbuffer.hpp"
+
+using namespace std;
+
+/* Subdivisions of the icosahedron (1: 42 vertices, 80 triangles) */
+#define LIGHT_GIZMO_SUBDIVISIONS 1
+
+/* Radius of the gizmo of the adjustable light and of the point lights */
+#define LIGHT_GIZMO_SIZE 0.1f
+#define POINT_LIGHT_GIZMO_SIZE 0.05f
+
+/* Initial per-frame size of the instance ring; it grows when a frame has more lights */
+#define LIGHT_GIZMO_INSTANCE_BYTES (16 * 1024)
+
+/* Per-instance vertex attributes of gizmo.vs (vInstance and vInstance + 1) */
+typedef struct
+{
+    float position[4];          // world space, the fourth value is the radius
+    float color[4];
+} GizmoInstance;
+
+/******************************************************************
+*
+* Marks where the lights are: a small sphere in the light's color
+* for the adjustable light and for every point light. The icosphere
+* is generated and uploaded once; each frame writes one instance per
+* light into a streaming ring and draws all of them with a single
+* glDrawElementsInstanced.
+*
+*******************************************************************/
+class LightGizmos
+{
+private:
+    ShaderVariants *programs;
+    GLuint VAO;
+    GLuint VBO;
+    GLuint IBO;
+    GLsizei indexCount;
+
+    StreamBuffer *instanceRing;
+    vector<GizmoInstance> instances;
+
+    static void buildIcosphere(int subdivisions, vector<float> *positions, vector<GLushort> *indices);
+
+public:
+    LightGizmos();
+
+    ~LightGizmos();
+
+    void draw(const LightUniforms *light, const vector<PointLight> &lights);
+
+    int getInstances();
+};
+
+#endif /* LIGHTGIZMOS_H */
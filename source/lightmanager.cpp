@@ -0,0 +1,60 @@
+#include "lightmanager.hpp"
+
+/******************************************************************
+*
+* @brief Adds a point light in world space
+*
+* @param radius = distance at which the light has faded to zero
+* @return the number of the light, for setPosition and setColor
+*******************************************************************/
+int LightManager::add(Vector position, Vector color, float radius, float intensity)
+{
+    lights.push_back({{position.x, position.y, position.z}, radius, {color.x, color.y, color.z}, intensity});
+    return lights.size() - 1;
+}
+
+void LightManager::setPosition(int light, Vector position)
+{
+    lights[light].position[0] = position.x;
+    lights[light].position[1] = position.y;
+    lights[light].position[2] = position.z;
+}
+
+void LightManager::setColor(int light, Vector color)
+{
+    lights[light].color[0] = color.x;
+    lights[light].color[1] = color.y;
+    lights[light].color[2] = color.z;
+}
+
+/******************************************************************
+*
+* @brief Hangs 'count' work lights with random warm to neutral
+* white tints at 'height' over a square workcell
+*
+* @param extent = half the side of the workcell
+* @param random = random number engine, advanced by the call
+*******************************************************************/
+void LightManager::scatter(int count, float extent, float height, minstd_rand *random)
+{
+    uniform_real_distribution<float> side(-extent, extent);
+    uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for (int i = 0; i < count; i++)
+    {
+        float x = side(*random);
+        float z = side(*random);
+        float warmth = unit(*random);
+        add(Vector{x, height, z}, Vector{1.0f, 0.8f + 0.2f * warmth, 0.6f + 0.4f * warmth}, WORK_LIGHT_RADIUS, 0.8f);
+    }
+}
+
+/** Copies the lights into a scene snapshot */
+void LightManager::snapshot(vector<PointLight> *out)
+{
+    out->assign(lights.begin(), lights.end());
+}
+
+int LightManager::getCount()
+{
+    return lights.size();
+}
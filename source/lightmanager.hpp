@@ -0,0 +1,42 @@
+#ifndef LIGHTMANAGER_H
+#define LIGHTMANAGER_H
+
+#include <random>
+#include <vector>
+#include "LightClustering.hpp"
+#include "Vector.hpp"
+
+using namespace std;
+
+/* Reach of the indicator light on an arm's base and of the work lights over the workcell */
+#define INDICATOR_LIGHT_RADIUS 2.0f
+#define WORK_LIGHT_RADIUS 4.0f
+
+/******************************************************************
+*
+* The point lights of the workcell (indicator and work lights), in
+* addition to the one adjustable Light. Any number of lights can be
+* added; the render thread bins them into clusters, so each fragment
+* only shades with the few lights that reach it.
+*
+*******************************************************************/
+class LightManager
+{
+private:
+    vector<PointLight> lights;
+
+public:
+    int add(Vector position, Vector color, float radius, float intensity);
+
+    void setPosition(int light, Vector position);
+
+    void setColor(int light, Vector color);
+
+    void scatter(int count, float extent, float height, minstd_rand *random);
+
+    void snapshot(vector<PointLight> *out);
+
+    int getCount();
+};
+
+#endif /* LIGHTMANAGER_H */
@@ -1,26 +1,37 @@
 #include "limb.hpp"
+#include "arm.hpp"
 #include "utils.hpp"
+#include "assetregistry.hpp"
 
 using namespace std;
 /******************************************************************
 *
-* Constructs a limb using the
+* Constructs a limb using the given mesh and texture, which are
+* shared through 'assets'
 *
 *******************************************************************/
-Limb::Limb(Arm *_arm, int _ID, string filename, string texture, float _position[3], float scale) :
+Limb::Limb(Arm *_arm, int _ID, string filename, string texture, float _position[3], float scale,
+           AssetRegistry *_assets) :
         arm(_arm), rotationX(0), rotationY(0), rotationZ(0),
         position{_position[0], _position[1], _position[2]},
-        internal{0}, transformation{0}, model{0}
+        assets(_assets), internal{0}, transformation{0}, model{0}
 {
     ID = _ID;
 
-    readMeshFile(filename, scale, &NBO, &VAO);
-    SetupTexture(&TextureID, texture.c_str());
+    mesh = assets->acquireMesh(filename, scale);
+    TextureID = assets->acquireTexture(texture);
     SetIdentityMatrix(internal);
     SetIdentityMatrix(transformation);
     SetIdentityMatrix(model);
 }
 
+/** Releases the limb's mesh and texture */
+Limb::~Limb()
+{
+    assets->releaseMesh(mesh);
+    assets->releaseTexture(TextureID);
+}
+
 void Limb::setRotation(int axis, float deg)
 {
     std::string axis_name;
@@ -61,6 +72,13 @@ float Limb::getRotation(int axis)
     }
 }
 
+/** Sets the rotations around the x and y axis without reporting them */
+void Limb::setPose(float x, float y)
+{
+    rotationX = x;
+    rotationY = y;
+}
+
 void Limb::setAngle(int deg)
 {
     angle = deg;
@@ -110,25 +128,12 @@ void Limb::update(float *parentTransform)
     MultiplyMatrix(transformation, model, transformation);
 }
 
-void Limb::display(GLint program)
+/** Adds the limb with its current model matrix to a scene snapshot */
+void Limb::snapshot(SceneSnapshot *scene)
 {
-    GLint size;
-    glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &size);
-
-    GLint ModelUniform = glGetUniformLocation(program, "TransformMatrix");
-    if (ModelUniform == -1)
-    {
-        fprintf(stderr, "Could not bind uniform Transform Matrix for Limb %d.\n", ID);
-        exit(-1);
-    }
-    glUniformMatrix4fv(ModelUniform, 1, GL_TRUE, model);
-
-    glBindVertexArray(VAO);
-    /* Draw the data contained in the VAO */
-    glDrawElements(GL_TRIANGLES, size / sizeof(GLushort), GL_UNSIGNED_SHORT, nullptr);
-
-    /* Bind current texture  */
-    glBindTexture(GL_TEXTURE_2D, TextureID);
-
-    glBindVertexArray(0);
+    SnapshotItem item;
+    item.mesh = mesh;
+    item.texture = TextureID;
+    memcpy(item.model, model, 16 * sizeof(float));
+    scene->items.push_back(item);
 }
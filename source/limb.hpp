@@ -10,8 +10,11 @@
 #include "utils.hpp"
 #include "Matrix.h"
 #include "Vector.hpp"
+#include "scenesnapshot.hpp"
 
 class Arm;
+class AssetRegistry;
+
 
 class Limb
 {
@@ -22,8 +25,7 @@ private:
     std::string filename;
     std::string texture;
 
-    GLuint VAO;
-    GLuint NBO; // normals
+    const Mesh *mesh;
 
     float rotationX;
     float rotationY;
@@ -35,7 +37,9 @@ private:
 
     float position[3];
 
-    GLuint TextureID;
+    const GLuint *TextureID;
+
+    AssetRegistry *assets;
 
     // internal is used for internal transformations like scale
     float internal[16];
@@ -44,7 +48,10 @@ private:
     float model[16];
 
 public:
-    Limb(Arm *arm, int ID, std::string filename, std::string texture, float position[3], float scale);
+    Limb(Arm *arm, int ID, std::string filename, std::string texture, float position[3], float scale,
+         AssetRegistry *assets);
+
+    ~Limb();
 
     void setRotation(int axis, float deg);
 
@@ -56,7 +63,9 @@ public:
 
     void update(float *transformation);
 
-    void display(GLint program);
+    void setPose(float x, float y);
+
+    void snapshot(SceneSnapshot *scene);
 
 };
 
@@ -2,6 +2,8 @@
 #include <cstdio>
 #include <iostream>
 #include <cstdlib>
+#include <chrono>
+#include <thread>
 
 /* OpenGL includes */
 #include <GL/glew.h>
@@ -11,8 +13,29 @@
 #include "arm.hpp"
 #include "utils.hpp"
 #include "camera.hpp"
+#include "glstate.hpp"
+#include "scenesnapshot.hpp"
+#include "renderthread.hpp"
+#include "assetregistry.hpp"
 #include "light.hpp"
 #include "lightsetting.hpp"
+#include "lightmanager.hpp"
+
+/* Distance between the bases of the arms in stress mode (--arms N) */
+#define ARM_FLEET_SPACING 3.0f
+
+/* Heights of the indicator light on each arm's base and of the work lights (--lights L) */
+#define INDICATOR_LIGHT_HEIGHT 0.8f
+#define WORK_LIGHT_HEIGHT 4.0f
+
+/* Smallest half side of the workcell the work lights are spread over */
+#define WORKCELL_MIN_EXTENT 5.0f
+
+/* Seconds between two frame statistics in stress mode */
+#define FLEET_REPORT_INTERVAL 2.0
+
+/* Simulation steps per second; rendering runs at its own rate */
+#define SIMULATION_RATE 60.0
 
 /* Window parameters */
 float winWidth = 1000.0f;
@@ -21,6 +44,9 @@ float winHeight = 800.0f;
 /* window */
 GLFWwindow *window;
 
+/* owns the GL context while the simulation runs */
+RenderThread *renderThread = nullptr;
+
 KeyboardState keyboard = {
         .up = 0,
         .down = 0,
@@ -61,8 +87,8 @@ void Initialize()
     glClearColor(0.1, 0.1, 0.1, 0.0);
 
     /* Enable depth testing */
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LESS);
+    GLState::setDepthTest(1);
+    GLState::setDepthFunc(GL_LESS);
 
 }
 
@@ -77,8 +103,9 @@ void Initialize()
 
 void Resize(GLFWwindow *window, int width, int height)
 {
-    /* update viewport with new dimensions */
-    glViewport(0, 0, width, height);
+    /* update viewport with new dimensions (on the thread that owns the context) */
+    if (renderThread != nullptr)
+        renderThread->resize(width, height);
 }
 
 
@@ -144,7 +171,7 @@ void keyCallback(GLFWwindow *window, int key, int scancode, int action, int mods
     } else if (key == GLFW_KEY_Q && action == GLFW_PRESS)
     {
         std::cout << "Bye!" << std::endl;
-        exit(0);
+        glfwSetWindowShouldClose(window, GL_TRUE);
     } else if ((key == GLFW_KEY_4 || key == GLFW_KEY_5 || key == GLFW_KEY_6) && action == GLFW_PRESS)
     {
         keyboard.currentLimb = 0;
@@ -235,12 +262,48 @@ void mouseCallback(GLFWwindow *window, double xpos, double ypos)
 
 /******************************************************************
 *
-* @brief Main function to setup GLUT, GLEW, and enter rendering loop
+* @brief Creates an arm with its three limbs; all arms share the
+* meshes and textures through 'assets'
+*
+*******************************************************************/
+Arm *CreateArm(Camera *camera, AssetRegistry *assets)
+{
+    Arm *arm = new Arm(camera, assets);
+    arm->addLimb("../models/segment.obj", "../textures/stripes.bmp", 0.3, 0.3f);
+    arm->addLimb("../models/segment-2.obj", "../textures/metal.bmp", 1.7, 0.3f);
+    arm->addLimb("../models/banana.obj", "../textures/wood.bmp", 1.45, 0.25f);
+    return arm;
+}
+
+/******************************************************************
+*
+* @brief Main function to setup GLFW, GLEW, start the render thread
+* and enter the simulation loop
+*
+* Usage: ./assign_5 [--arms N] [--lights L]
+*        With --arms, N arms with random joint angles are placed on a
+*        grid and the draw calls, CPU time per frame and snapshot age
+*        are reported. Every arm has an indicator light on its base;
+*        --lights hangs L work lights over the workcell.
 *
 *******************************************************************/
 
 int main(int argc, char **argv)
 {
+    int armCount = 1;
+    int workLights = 0;
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--arms") == 0 && i + 1 < argc)
+            armCount = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--lights") == 0 && i + 1 < argc)
+            workLights = atoi(argv[++i]);
+    }
+    if (armCount < 1 || workLights < 0)
+    {
+        fprintf(stderr, "Usage: %s [--arms N] [--lights L]\n", argv[0]);
+        return 1;
+    }
 
     /* Initialize GLFW and create a window */
     glfwInit();
@@ -270,52 +333,130 @@ int main(int argc, char **argv)
     }
     std::cout << "OpenGL version: " << glGetString(GL_VERSION) << std::endl;
 
-    /* Setup shaders and shader program */
-    GLuint ShaderProgram = CreateShaderProgram(
-            "../shaders/phong.vs",
-            "../shaders/phong.fs"
-    );
-
     Camera camera(Vector{0, 0, -17});
 
     /* Setup scene and rendering parameters */
     Initialize();
 
-    /* Initialize arm and add limbs */
-    Arm arm(&camera);
-    arm.addLimb("../models/segment.obj", "../textures/stripes.bmp", 0.3, 0.3f);
-    arm.addLimb("../models/segment-2.obj", "../textures/metal.bmp", 1.7, 0.3f);
-    arm.addLimb("../models/banana.obj", "../textures/wood.bmp", 1.45, 0.25f);
+    /* Meshes and textures are loaded in the background, uploaded between
+     * frames and shared by everything that uses the same file */
+    AssetRegistry *assets = new AssetRegistry();
+
+    /* Initialize the arms (a fleet of one unless --arms is given), each with an indicator light on its base */
+    vector<Arm *> arms;
+    LightManager pointLights;
+    minstd_rand random(1);
+    float workcell = WORKCELL_MIN_EXTENT;     // half the side of the area the arms stand on
+    if (armCount == 1)
+    {
+        arms.push_back(CreateArm(&camera, assets));
+        pointLights.add(Vector{0, INDICATOR_LIGHT_HEIGHT, 0}, Vector{0, 1, 0}, INDICATOR_LIGHT_RADIUS, 1.0f);
+    } else
+    {
+        int columns = (int) ceilf(sqrtf(armCount));
+        float origin = (columns - 1) * ARM_FLEET_SPACING * 0.5f;
+        workcell = fmaxf(workcell, columns * ARM_FLEET_SPACING * 0.5f);
+
+        for (int i = 0; i < armCount; i++)
+        {
+            Arm *arm = CreateArm(&camera, assets);
+            float x = (i % columns) * ARM_FLEET_SPACING - origin;
+            float z = (i / columns) * ARM_FLEET_SPACING - origin;
+            arm->setPosition(x, 0, z);
+            arm->randomizePose(&random);
+            arms.push_back(arm);
+
+            /* green for running, orange for every seventh arm waiting */
+            pointLights.add(Vector{x, INDICATOR_LIGHT_HEIGHT, z}, i % 7 == 6 ? Vector{1, 0.5, 0} : Vector{0, 1, 0},
+                            INDICATOR_LIGHT_RADIUS, 1.0f);
+        }
+    }
+    pointLights.scatter(workLights, workcell, WORK_LIGHT_HEIGHT, &random);
 
     LightSettings lightSettings(0.5, 0.2, 0.4);
     Light light(lightSettings, Vector{1.2, 1.0, 3.0}, Vector{1, 0.5, 0});
 
-    /* Rendering loop */
+    /* The simulation below publishes a snapshot per step; the render thread,
+     * which owns the GL context from here on, draws the latest one */
+    SnapshotBuffer *snapshots = new SnapshotBuffer();
+    renderThread = new RenderThread(window, snapshots, assets);
+
+    double reportStart = glfwGetTime();
+    double simulationTime = 0;
+    int steps = 0;
+    double nextStep = glfwGetTime();
+    int rendering = 0;
+
+    /* Simulation loop */
     while (!glfwWindowShouldClose(window))
     {
         glfwPollEvents();
+        double stepStart = glfwGetTime();
 
         /* Update scene */
-        arm.update(&keyboard);
+        for (auto arm : arms)
+            arm->update(&keyboard);
         camera.UpdatePosition(&keyboard, &mouse);
         camera.UpdateZoom(&scrollWheel);
+        light.Update(&keyboard);
 
-        glUseProgram(ShaderProgram);
-
-        // draw scene
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        /* Publish it; the render thread starts with the first snapshot */
+        SceneSnapshot *scene = snapshots->getBack();
+        scene->items.clear();
+        for (auto arm : arms)
+            arm->snapshot(scene);
+        camera.Snapshot(&scene->camera);
+        light.Snapshot(&scene->light);
+        pointLights.snapshot(&scene->lights);
+        snapshots->publish();
+        if (!rendering)
+        {
+            renderThread->start();
+            rendering = 1;
+        }
 
-        // update camera
-        camera.Shoot(ShaderProgram);
+        simulationTime += glfwGetTime() - stepStart;
+        steps++;
 
-        light.Update(&keyboard);
-        light.LightUpScene(ShaderProgram);
+        if (armCount > 1 && glfwGetTime() - reportStart >= FLEET_REPORT_INTERVAL)
+        {
+            RenderStatistics frames = renderThread->takeStatistics();
+            double interval = glfwGetTime() - reportStart;
+            int frameCount = frames.frames > 0 ? frames.frames : 1;
+            printf("%d arms: %d parts visible, %d culled, %d draw items sorted in %.3f ms, %d draw calls, "
+                   "%d draw commands, %d state runs, %d/%d state calls issued/elided, %.2f ms CPU per frame, "
+                   "%.1f fps\n", armCount, frames.visibleItems, frames.culledItems, frames.drawItems, frames.sortTime,
+                   frames.drawCalls, frames.drawCommands, frames.stateRuns, frames.stateCalls.issued,
+                   frames.stateCalls.elided, frames.cpuTime / frameCount, frames.frames / interval);
+            printf("    simulation %.2f ms per step, %.1f steps/s; snapshot age %.1f ms (max %.1f ms), "
+                   "%d of %d frames reused a snapshot\n", simulationTime * 1000.0 / steps, steps / interval,
+                   frames.snapshotAge / frameCount, frames.maxSnapshotAge, frames.reusedFrames, frames.frames);
+            printf("    streaming buffers: %d fence waits (%.2f ms), %d rings grown\n", frames.fences.waits,
+                   frames.fences.waitTime, frames.fences.reallocations);
+            printf("    point lights: %d of %d visible, %d cluster entries, binned in %.3f ms\n", frames.pointLights,
+                   pointLights.getCount(), frames.clusterIndices, frames.clusterTime);
+            reportStart = glfwGetTime();
+            simulationTime = 0;
+            steps = 0;
+        }
 
-        arm.display(ShaderProgram);
-        /* Swap between front and back buffer */
-        glfwSwapBuffers(window);
+        /* Fixed rate, since every step moves by a fixed amount; skip ahead after a spike */
+        nextStep += 1.0 / SIMULATION_RATE;
+        double wait = nextStep - glfwGetTime();
+        if (wait > 0)
+            this_thread::sleep_for(chrono::duration<double>(wait));
+        else
+            nextStep = glfwGetTime();
     }
 
+    /* Take the GL context back and release the GL objects while it is still current */
+    delete renderThread;
+    renderThread = nullptr;
+    delete snapshots;
+    for (auto arm : arms)
+        delete arm;
+    delete assets;
+
     /* Close window */
     glfwDestroyWindow(window);
     glfwTerminate();
@@ -0,0 +1,177 @@
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include <sys/stat.h>
+
+#ifdef WIN32
+#include <direct.h>
+#endif
+
+#include "programcache.hpp"
+#include "glstate.hpp"
+#include <GLFW/glfw3.h>
+
+int ProgramCache::support = -1;
+ProgramCacheCounters ProgramCache::counters = {0, 0, 0, 0, 0};
+
+/** Program binaries need GL 4.1 or ARB_get_program_binary and at least one binary format */
+int ProgramCache::isSupported()
+{
+    if (support < 0)
+    {
+        GLint formats = 0;
+        if (GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary)
+            glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        support = formats > 0;
+    }
+    return support;
+}
+
+string ProgramCache::path(uint64_t key)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "/program-%016llx.glprog", (unsigned long long) key);
+    return string(PROGRAM_CACHE_DIR) + name;
+}
+
+/******************************************************************
+*
+* @brief Hashes (FNV-1a, as the mesh cache) everything a program
+* binary depends on; needs a current GL context for the driver
+* strings
+*
+*******************************************************************/
+uint64_t ProgramCache::key(const string &vertexSource, const string &fragmentSource, const string &defines)
+{
+    const char *driver[3] = {(const char *) glGetString(GL_VENDOR), (const char *) glGetString(GL_RENDERER),
+                             (const char *) glGetString(GL_VERSION)};
+
+    uint64_t hash = 14695981039346656037ull;
+    auto add = [&hash](const char *text, size_t length) {
+        for (size_t i = 0; i < length; i++)
+        {
+            hash ^= (unsigned char) text[i];
+            hash *= 1099511628211ull;
+        }
+        /* separator, so that moving text between the parts changes the key */
+        hash ^= 0xff;
+        hash *= 1099511628211ull;
+    };
+
+    add(vertexSource.data(), vertexSource.size());
+    add(fragmentSource.data(), fragmentSource.size());
+    add(defines.data(), defines.size());
+    for (const char *text : driver)
+        add(text != nullptr ? text : "", text != nullptr ? strlen(text) : 0);
+    return hash;
+}
+
+/******************************************************************
+*
+* @brief Creates a program from the cached binary for 'key'
+*
+* @return the linked program, or 0 if there is no usable binary
+*******************************************************************/
+GLuint ProgramCache::load(uint64_t key)
+{
+    if (!isSupported())
+        return 0;
+
+    double start = glfwGetTime();
+    string file = path(key);
+    FILE *in = fopen(file.c_str(), "rb");
+    if (in == nullptr)
+        return 0;
+
+    ProgramBinaryHeader header;
+    vector<char> binary;
+    int valid = fread(&header, sizeof(header), 1, in) == 1 && header.magic == PROGRAM_CACHE_MAGIC &&
+                header.version == PROGRAM_CACHE_VERSION && header.key == key;
+    if (valid)
+    {
+        binary.resize(header.size);
+        valid = fread(binary.data(), 1, binary.size(), in) == binary.size();
+    }
+    fclose(in);
+
+    GLuint program = 0;
+    if (valid)
+    {
+        program = glCreateProgram();
+        glProgramBinary(program, header.format, binary.data(), binary.size());
+
+        GLint linked = 0;
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (!linked)
+        {
+            GLState::deleteProgram(program);
+            program = 0;
+        }
+    }
+
+    if (program == 0)
+    {
+        remove(file.c_str());
+        counters.rejected++;
+        return 0;
+    }
+
+    counters.loaded++;
+    counters.loadTime += (glfwGetTime() - start) * 1000.0;
+    return program;
+}
+
+/** Asks the driver to keep the binary of a program that is about to be linked */
+void ProgramCache::prepare(GLuint program)
+{
+    if (isSupported())
+        glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+}
+
+/** Writes the binary of a linked program; a failure only costs the next start a compile */
+void ProgramCache::store(GLuint program, uint64_t key)
+{
+    if (!isSupported())
+        return;
+
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0)
+        return;
+
+    ProgramBinaryHeader header = {PROGRAM_CACHE_MAGIC, PROGRAM_CACHE_VERSION, key, 0, 0};
+    vector<char> binary(length);
+    GLsizei written = 0;
+    glGetProgramBinary(program, length, &written, &header.format, binary.data());
+    header.size = written;
+
+#ifdef WIN32
+    _mkdir(PROGRAM_CACHE_DIR);
+#else
+    mkdir(PROGRAM_CACHE_DIR, 0755);
+#endif
+    /* written under a temporary name and renamed, so a crash never leaves a partial binary */
+    string file = path(key);
+    string tempFile = file + ".tmp";
+    FILE *out = fopen(tempFile.c_str(), "wb");
+    if (out == nullptr)
+        return;
+
+    int complete = fwrite(&header, sizeof(header), 1, out) == 1 &&
+                   fwrite(binary.data(), 1, written, out) == (size_t) written;
+    complete = (fclose(out) == 0) && complete;
+    if (!complete || rename(tempFile.c_str(), file.c_str()) != 0)
+        remove(tempFile.c_str());
+}
+
+/** Records a program that had to be compiled from source */
+void ProgramCache::countCompile(double milliseconds)
+{
+    counters.compiled++;
+    counters.compileTime += milliseconds;
+}
+
+ProgramCacheCounters ProgramCache::getCounters()
+{
+    return counters;
+}
@@ -0,0 +1,71 @@
+#ifndef PROGRAMCACHE_H
+#define PROGRAMCACHE_H
+
+#include <cstdint>
+#include <string>
+#include <GL/glew.h>
+
+using namespace std;
+
+/* Folder of the program binaries, shared with the mesh cache */
+#define PROGRAM_CACHE_DIR "cache"
+
+/* Identifies a program binary file; bump the version when the layout changes */
+#define PROGRAM_CACHE_MAGIC 0x42504c47u  // "GLPB"
+#define PROGRAM_CACHE_VERSION 1
+
+/* Header of cache/<key>.glprog, followed by 'size' bytes of driver binary */
+typedef struct
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t key;
+    uint32_t format;            // binary format reported by the driver
+    uint32_t size;
+} ProgramBinaryHeader;
+
+/* How the programs of this run were created */
+typedef struct
+{
+    int loaded;                 // from a cached binary
+    int compiled;               // from source, no usable binary
+    int rejected;               // binaries the driver did not accept any more
+    double loadTime;            // in ms
+    double compileTime;
+} ProgramCacheCounters;
+
+/******************************************************************
+*
+* Stores linked programs as driver binaries (glGetProgramBinary) and
+* restores them with glProgramBinary on later starts. Entries are
+* keyed by a hash of the shader sources, their defines and the GL
+* vendor, renderer and version, so an edited shader or a driver
+* update simply misses; a binary the driver rejects anyway is
+* deleted and the program is compiled from source again.
+*
+*******************************************************************/
+class ProgramCache
+{
+private:
+    static int support;         // -1 until detected
+    static ProgramCacheCounters counters;
+
+    static int isSupported();
+
+    static string path(uint64_t key);
+
+public:
+    static uint64_t key(const string &vertexSource, const string &fragmentSource, const string &defines);
+
+    static GLuint load(uint64_t key);
+
+    static void prepare(GLuint program);
+
+    static void store(GLuint program, uint64_t key);
+
+    static void countCompile(double milliseconds);
+
+    static ProgramCacheCounters getCounters();
+};
+
+#endif /* PROGRAMCACHE_H */
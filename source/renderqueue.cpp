@@ -0,0 +1,291 @@
+#include "renderqueue.hpp"
+#include "glstate.hpp"
+#include "Matrix.h"
+
+/** Creates the instance and command buffers; needs a current GL context */
+RenderQueue::RenderQueue() :
+        view{0}, drawCalls(0), sortTime(0)
+{
+    instanceRing = new StreamBuffer(RENDER_QUEUE_INSTANCE_BYTES, sizeof(InstanceData));
+    commandRing = new StreamBuffer(RENDER_QUEUE_COMMAND_BYTES, sizeof(DrawCommand));
+
+    /* the instance attributes of indirect commands are offset by their base instance */
+    baseInstance = GLEW_VERSION_4_2 || GLEW_ARB_base_instance;
+    multiDraw = baseInstance && (GLEW_VERSION_4_3 || GLEW_ARB_multi_draw_indirect);
+    printf("Draw submission: %s\n", multiDraw ? "glMultiDrawElementsIndirect" :
+                                    baseInstance ? "one draw per command (no multi-draw indirect)" :
+                                    "one draw per command (no base instance)");
+}
+
+RenderQueue::~RenderQueue()
+{
+    delete instanceRing;
+    delete commandRing;
+}
+
+/** Starts collecting the draw items of a frame seen through 'view' */
+void RenderQueue::reset(const float *_view)
+{
+    memcpy(view, _view, sizeof(view));
+    items.clear();
+    keys.clear();
+    drawCalls = 0;
+}
+
+/******************************************************************
+*
+* @brief Adds a draw item to the frame; meshes that are not resident
+* yet are skipped. The item's texture and model matrix are copied,
+* so they may change afterwards.
+*
+*******************************************************************/
+void RenderQueue::push(const DrawItem &item)
+{
+    const Mesh *mesh = item.mesh;
+    if (mesh->lodCount == 0)
+        return;
+
+    QueuedItem queued;
+    queued.program = item.program;
+    queued.mesh = mesh;
+    queued.texture = *item.texture;
+    queued.lod = item.lod;
+
+    /* model-view and normal matrix once per instance instead of once per vertex */
+    float modelView[16];
+    float normal[9];
+    MultiplyMatrix(view, item.model, modelView);
+    SetNormalMatrix(modelView, normal);
+    memcpy(queued.instance.modelView, modelView, sizeof(queued.instance.modelView));
+    for (int row = 0; row < 3; row++)
+    {
+        memcpy(&queued.instance.normal[row * 4], &normal[row * 3], 3 * sizeof(float));
+        queued.instance.normal[row * 4 + 3] = 0.0f;
+    }
+    for (int k = 0; k < 3; k++)
+    {
+        queued.instance.positionScale[k] = mesh->positionScale[k];
+        queued.instance.positionBias[k] = mesh->positionBias[k];
+    }
+    queued.instance.positionScale[3] = 0.0f;
+    queued.instance.positionBias[3] = 0.0f;
+
+    /* distance of the object's origin in front of the camera (which looks down -z) */
+    float depth = -modelView[11];
+    depth = depth < 0 ? 0 : (depth > RENDER_QUEUE_DEPTH_RANGE ? 1 : depth / RENDER_QUEUE_DEPTH_RANGE);
+
+    /* names are truncated to their field; a collision only costs an extra command */
+    uint64_t key = (uint64_t) (item.program->getID() & 0xff) << 56 |
+                   (uint64_t) (mesh->VAO & 0xff) << 48 |
+                   (uint64_t) (queued.texture & 0xfff) << 36 |
+                   (uint64_t) (mesh->sortId & 0xfff) << 24 |
+                   (uint64_t) (item.lod & 0x3) << 22 |
+                   (uint64_t) (depth * 0x3fffff);
+
+    keys.push_back({key, (uint32_t) items.size()});
+    items.push_back(queued);
+}
+
+/******************************************************************
+*
+* @brief Sorts the keys with an LSD radix sort, one byte per pass;
+* passes in which all keys share the byte are skipped
+*
+*******************************************************************/
+void RenderQueue::radixSort(vector<SortEntry> *keys, vector<SortEntry> *scratch)
+{
+    scratch->resize(keys->size());
+
+    for (int shift = 0; shift < 64; shift += 8)
+    {
+        size_t histogram[256] = {0};
+        for (const SortEntry &entry : *keys)
+            histogram[(entry.key >> shift) & 0xff]++;
+
+        if (keys->empty() || histogram[((*keys)[0].key >> shift) & 0xff] == keys->size())
+            continue;
+
+        size_t offset = 0;
+        for (size_t &count : histogram)
+        {
+            size_t next = offset + count;
+            count = offset;
+            offset = next;
+        }
+
+        for (const SortEntry &entry : *keys)
+            (*scratch)[histogram[(entry.key >> shift) & 0xff]++] = entry;
+        keys->swap(*scratch);
+    }
+}
+
+/******************************************************************
+*
+* @brief Sorts the frame's items, merges items that differ only in
+* depth into instanced draw commands and writes the instances and
+* commands into the next regions of their rings
+*
+*******************************************************************/
+void RenderQueue::stage()
+{
+    double start = glfwGetTime();
+    radixSort(&keys, &scratch);
+    sortTime = (glfwGetTime() - start) * 1000.0;
+
+    instances.clear();
+    commands.clear();
+    runs.clear();
+
+    const QueuedItem *previous = nullptr;
+    for (const SortEntry &entry : keys)
+    {
+        const QueuedItem &item = items[entry.item];
+        const Mesh *mesh = item.mesh;
+
+        if (previous == nullptr || previous->program != item.program || previous->mesh != mesh ||
+            previous->lod != item.lod || previous->texture != item.texture)
+        {
+            const MeshLevel &lod = mesh->lods[item.lod];
+            GLuint indexSize = mesh->indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+
+            DrawCommand command;
+            command.count = lod.indexCount;
+            command.instanceCount = 0;
+            command.firstIndex = mesh->firstIndex + lod.indexOffset / indexSize;
+            command.baseVertex = mesh->baseVertex;
+            command.baseInstance = instances.size();
+
+            if (runs.empty() || runs.back().program != item.program || runs.back().VAO != mesh->VAO ||
+                runs.back().texture != item.texture)
+            {
+                runs.push_back({item.program, mesh->VAO, item.texture, mesh->indexType, commands.size(), 0});
+            }
+            runs.back().commandCount++;
+            commands.push_back(command);
+        }
+
+        commands.back().instanceCount++;
+        instances.push_back(item.instance);
+        previous = &item;
+    }
+
+    size_t instanceBytes = instances.size() * sizeof(InstanceData);
+    memcpy(instanceRing->map(instanceBytes), instances.data(), instanceBytes);
+    instanceRing->unmap();
+
+    if (multiDraw)
+    {
+        size_t commandBytes = commands.size() * sizeof(DrawCommand);
+        memcpy(commandRing->map(commandBytes), commands.data(), commandBytes);
+        commandRing->unmap();
+    }
+}
+
+/* Points the instance attributes of the bound VAO at the instance buffer */
+void RenderQueue::setInstancePointers(GLuint firstInstance)
+{
+    size_t base = instanceRing->getOffset() + firstInstance * sizeof(InstanceData);
+
+    GLState::bindBuffer(GL_ARRAY_BUFFER, instanceRing->getBuffer());
+    for (int row = 0; row < 3; row++)
+    {
+        glVertexAttribPointer(vInstance + row, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                              (void *) (base + offsetof(InstanceData, modelView) + row * 4 * sizeof(float)));
+        glVertexAttribPointer(vInstanceNormal + row, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                              (void *) (base + offsetof(InstanceData, normal) + row * 4 * sizeof(float)));
+    }
+    glVertexAttribPointer(vInstanceScale, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                          (void *) (base + offsetof(InstanceData, positionScale)));
+    glVertexAttribPointer(vInstanceBias, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData),
+                          (void *) (base + offsetof(InstanceData, positionBias)));
+}
+
+/** Submits the commands built by stage(); all state is bound before each draw */
+void RenderQueue::draw()
+{
+    /* Activate the unit of the part textures; the cluster buffer textures stay bound to the units after it */
+    GLState::activeTexture(GL_TEXTURE0 + TEXTURE_UNIT_PART);
+
+    /* Use filled polygons rendering */
+    GLState::setPolygonMode(GL_FILL);
+
+    if (multiDraw)
+        GLState::bindBuffer(GL_DRAW_INDIRECT_BUFFER, commandRing->getBuffer());
+
+    ShaderProgram *program = nullptr;
+    GLuint boundVAO = 0;
+    for (const Run &run : runs)
+    {
+        if (run.program != program)
+        {
+            program = run.program;
+            program->use();
+        }
+
+        GLState::bindTexture(GL_TEXTURE_2D, run.texture);
+        if (run.VAO != boundVAO)
+        {
+            GLState::bindVertexArray(run.VAO);
+            if (baseInstance)
+                setInstancePointers(0);
+            boundVAO = run.VAO;
+        }
+
+        if (multiDraw)
+        {
+            size_t indirect = commandRing->getOffset() + run.firstCommand * sizeof(DrawCommand);
+            glMultiDrawElementsIndirect(GL_TRIANGLES, run.indexType, (void *) indirect, run.commandCount, 0);
+            drawCalls++;
+        } else
+        {
+            GLuint indexSize = run.indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+            for (size_t c = run.firstCommand; c < run.firstCommand + run.commandCount; c++)
+            {
+                const DrawCommand &command = commands[c];
+                void *indices = (void *) ((size_t) command.firstIndex * indexSize);
+                if (baseInstance)
+                {
+                    glDrawElementsInstancedBaseVertexBaseInstance(GL_TRIANGLES, command.count, run.indexType, indices,
+                                                                  command.instanceCount, command.baseVertex,
+                                                                  command.baseInstance);
+                } else
+                {
+                    setInstancePointers(command.baseInstance);
+                    glDrawElementsInstancedBaseVertex(GL_TRIANGLES, command.count, run.indexType, indices,
+                                                      command.instanceCount, command.baseVertex);
+                }
+                drawCalls++;
+            }
+        }
+    }
+}
+
+/** Returns the draw items of the frame */
+int RenderQueue::getItems()
+{
+    return items.size();
+}
+
+/** Returns the draw calls of the last draw() */
+int RenderQueue::getDrawCalls()
+{
+    return drawCalls;
+}
+
+/** Returns the draw commands of the last stage(), one per mesh level, texture and program */
+int RenderQueue::getCommands()
+{
+    return commands.size();
+}
+
+/** Returns the state changes of the last stage(): runs of commands with the same program, arena and texture */
+int RenderQueue::getRuns()
+{
+    return runs.size();
+}
+
+/** Returns the time the last stage() spent sorting, in milliseconds */
+double RenderQueue::getSortTime()
+{
+    return sortTime;
+}
@@ -0,0 +1,137 @@
+#ifndef RENDERQUEUE_H
+#define RENDERQUEUE_H
+
+#include <cstdint>
+#include <vector>
+#include "utils.hpp"
+#include "shaderprogram.hpp"
+#include "streambuffer.hpp"
+
+using namespace std;
+
+/* Initial per-frame sizes of the instance and command rings; they grow when a frame needs more */
+#define RENDER_QUEUE_INSTANCE_BYTES (64 * 1024)
+#define RENDER_QUEUE_COMMAND_BYTES (4 * 1024)
+
+/* View space distance that the depth bits of a sort key cover (the camera's far plane) */
+#define RENDER_QUEUE_DEPTH_RANGE 100.0f
+
+/* Per-instance vertex attributes (vInstance to vInstanceBias in phong.vs), computed once per
+ * instance on the CPU so that the vertex shader needs no matrix products or inverses */
+typedef struct
+{
+    float modelView[12];        // rows 0 to 2 of view * model, row-major (row 3 is 0, 0, 0, 1)
+    float normal[12];           // rows of SetNormalMatrix(modelView), the fourth value is unused
+    float positionScale[4];     // decoding of the mesh's vertex format
+    float positionBias[4];
+} InstanceData;
+
+/* Layout of the commands of glMultiDrawElementsIndirect */
+typedef struct
+{
+    GLuint count;
+    GLuint instanceCount;
+    GLuint firstIndex;
+    GLint baseVertex;
+    GLuint baseInstance;
+} DrawCommand;
+
+/* Everything needed to draw one mesh level once */
+typedef struct
+{
+    ShaderProgram *program;
+    const Mesh *mesh;
+    const GLuint *texture;
+    int lod;
+    const float *model;         // row-major, read when the item is pushed
+} DrawItem;
+
+/******************************************************************
+*
+* Collects the draw items of a frame and submits them in an order
+* that minimizes state changes. Every item gets a 64-bit key,
+*
+*   program (8) | arena (8) | texture (12) | mesh (12) | level (2) |
+*   depth (22)
+*
+* and the keys are radix sorted. Items that share everything but
+* their depth become the instances of one draw command, front to
+* back; commands that share program, arena and texture are submitted
+* with one glMultiDrawElementsIndirect (or one by one where it is
+* missing).
+*
+*******************************************************************/
+class RenderQueue
+{
+private:
+    typedef struct
+    {
+        uint64_t key;
+        uint32_t item;
+    } SortEntry;
+
+    typedef struct
+    {
+        ShaderProgram *program;
+        const Mesh *mesh;
+        GLuint texture;
+        int lod;
+        InstanceData instance;
+    } QueuedItem;
+
+    /* consecutive commands that are submitted together */
+    typedef struct
+    {
+        ShaderProgram *program;
+        GLuint VAO;
+        GLuint texture;
+        GLenum indexType;
+        size_t firstCommand;
+        GLsizei commandCount;
+    } Run;
+
+    StreamBuffer *instanceRing;
+    StreamBuffer *commandRing;
+    int multiDraw;                  // glMultiDrawElementsIndirect is available
+    int baseInstance;               // draw commands can offset the instance attributes
+
+    float view[16];                 // for the depth of the items
+    vector<QueuedItem> items;
+    vector<SortEntry> keys;
+    vector<SortEntry> scratch;
+    vector<InstanceData> instances;
+    vector<DrawCommand> commands;
+    vector<Run> runs;
+
+    int drawCalls;
+    double sortTime;
+
+    static void radixSort(vector<SortEntry> *keys, vector<SortEntry> *scratch);
+
+    void setInstancePointers(GLuint firstInstance);
+
+public:
+    RenderQueue();
+
+    ~RenderQueue();
+
+    void reset(const float *view);
+
+    void push(const DrawItem &item);
+
+    void stage();
+
+    void draw();
+
+    int getItems();
+
+    int getDrawCalls();
+
+    int getCommands();
+
+    int getRuns();
+
+    double getSortTime();
+};
+
+#endif /* RENDERQUEUE_H */
@@ -0,0 +1,250 @@
+#include "renderthread.hpp"
+#include "camera.hpp"
+#include "programcache.hpp"
+
+/******************************************************************
+*
+* @brief Creates the shader programs, the frame's uniform buffer and
+* the render queue; needs the GL context to be current on the caller
+*
+*******************************************************************/
+RenderThread::RenderThread(GLFWwindow *_window, SnapshotBuffer *_snapshots, AssetRegistry *_assets) :
+        window(_window), snapshots(_snapshots), assets(_assets),
+        stopping(0), framebufferWidth(0), framebufferHeight(0), visibleItems(0), culledItems(0), statistics{}
+{
+    /* the framebuffer may have more pixels than the window on HiDPI screens */
+    int width;
+    glfwGetFramebufferSize(window, &width, &viewportHeight);
+
+    /* Setup shaders and a shader program per variant; their uniforms are resolved once here */
+    programs = new ShaderVariants(
+            "../shaders/phong.vs",
+            "../shaders/phong.fs",
+            SHADER_TEXTURED | SHADER_CLUSTERED_LIGHTS
+    );
+
+    /* Camera and light uniform blocks of a frame */
+    frameUniforms = new UniformBuffer();
+
+    /* Collects the draw items of all arms, sorts them and submits them from the geometry pool */
+    queue = new RenderQueue();
+
+    /* Point lights of the workcell, binned into clusters per frame */
+    clusterBuffers = new ClusterBuffers();
+
+    /* A shared icosphere per light, all drawn at once */
+    gizmos = new LightGizmos();
+}
+
+/** Stops the thread; the GL context is current on the caller again afterwards */
+RenderThread::~RenderThread()
+{
+    stopping = 1;
+    if (worker.joinable())
+        worker.join();
+
+    glfwMakeContextCurrent(window);
+    delete gizmos;
+    delete clusterBuffers;
+    delete queue;
+    delete frameUniforms;
+    delete programs;
+}
+
+/** Hands the GL context over to the render thread and starts it */
+void RenderThread::start()
+{
+    glfwMakeContextCurrent(nullptr);
+    worker = thread(&RenderThread::run, this);
+}
+
+/** Records a new framebuffer size; the viewport follows with the next frame */
+void RenderThread::resize(int width, int height)
+{
+    framebufferWidth = width;
+    framebufferHeight = height;
+}
+
+/** Returns the statistics of the frames since the last call */
+RenderStatistics RenderThread::takeStatistics()
+{
+    lock_guard<mutex> guard(statisticsLock);
+    RenderStatistics taken = statistics;
+    statistics.frames = 0;
+    statistics.reusedFrames = 0;
+    statistics.snapshotAge = 0;
+    statistics.maxSnapshotAge = 0;
+    statistics.cpuTime = 0;
+    statistics.fences = {0, 0, 0};
+    return taken;
+}
+
+void RenderThread::run()
+{
+    glfwMakeContextCurrent(window);
+
+    int firstFrame = 1;
+    int assetsResident = 0;
+
+    while (!stopping)
+    {
+        int fresh;
+        const SceneSnapshot *scene = snapshots->acquire(&fresh);
+        double frameStart = glfwGetTime();
+
+        /* Upload what the loader has finished, within the frame's budget */
+        int pendingAssets = assets->update(ASSET_UPLOAD_BUDGET_MS);
+
+        int width = framebufferWidth.exchange(0);
+        int height = framebufferHeight.exchange(0);
+        if (width > 0 && height > 0)
+        {
+            glViewport(0, 0, width, height);
+            viewportHeight = height;
+        }
+
+        renderFrame(scene);
+        int uniformUpdates = ShaderProgram::resetUpdates();
+        GLStateCounters stateCalls = GLState::resetCounters();
+        StreamBufferCounters fences = StreamBuffer::resetCounters();
+        double cpuTime = (glfwGetTime() - frameStart) * 1000.0;
+
+        /* Swap between front and back buffer */
+        glfwSwapBuffers(window);
+        double age = (glfwGetTime() - scene->time) * 1000.0;
+
+        if (firstFrame)
+        {
+            /* cold: some program had to be compiled, warm: all came from the binary cache */
+            ProgramCacheCounters programs = ProgramCache::getCounters();
+            printf("First frame after %.1f ms, %s start: %d shader programs loaded from the cache in %.1f ms, "
+                   "%d compiled in %.1f ms\n", glfwGetTime() * 1000.0, programs.compiled > 0 ? "cold" : "warm",
+                   programs.loaded, programs.loadTime, programs.compiled, programs.compileTime);
+            firstFrame = 0;
+        }
+        if (!assetsResident && pendingAssets == 0)
+        {
+            printf("All assets resident after %.1f ms\n", glfwGetTime() * 1000.0);
+            assets->printStatistics();
+            printf("Uniforms per frame: %d glUniform calls, %d block bindings, %zu bytes in one upload\n",
+                   uniformUpdates, frameUniforms->getBinds(), frameUniforms->getSize());
+            printf("GL state calls per frame: %d issued, %d elided\n", stateCalls.issued, stateCalls.elided);
+            printf("Frustum culling: %d parts visible, %d culled\n", visibleItems, culledItems);
+            printf("Point lights: %zu, %d visible, %d cluster entries, binned in %.3f ms, %d gizmos in one draw\n",
+                   scene->lights.size(), clusterBuffers->getLights(), clusterBuffers->getIndices(),
+                   clusterBuffers->getBuildTime(), gizmos->getInstances());
+            assetsResident = 1;
+        }
+
+        lock_guard<mutex> guard(statisticsLock);
+        statistics.frames++;
+        statistics.reusedFrames += !fresh;
+        statistics.snapshotAge += age;
+        statistics.maxSnapshotAge = age > statistics.maxSnapshotAge ? age : statistics.maxSnapshotAge;
+        statistics.cpuTime += cpuTime;
+        statistics.fences.waits += fences.waits;
+        statistics.fences.waitTime += fences.waitTime;
+        statistics.fences.reallocations += fences.reallocations;
+        statistics.visibleItems = visibleItems;
+        statistics.culledItems = culledItems;
+        statistics.pointLights = clusterBuffers->getLights();
+        statistics.clusterIndices = clusterBuffers->getIndices();
+        statistics.clusterTime = clusterBuffers->getBuildTime();
+        statistics.drawItems = queue->getItems();
+        statistics.drawCalls = queue->getDrawCalls();
+        statistics.drawCommands = queue->getCommands();
+        statistics.stateRuns = queue->getRuns();
+        statistics.sortTime = queue->getSortTime();
+        statistics.stateCalls = stateCalls;
+    }
+
+    glfwMakeContextCurrent(nullptr);
+}
+
+/******************************************************************
+*
+* @brief Collects the resident parts of a snapshot that intersect
+* its camera's view frustum into 'candidates'; their bounding spheres
+* are moved to world space with the model matrices of the snapshot
+*
+*******************************************************************/
+void RenderThread::cull(const SceneSnapshot *scene)
+{
+    candidates.clear();
+    for (const SnapshotItem &item : scene->items)
+    {
+        /* Nothing to draw until the loader made the mesh resident */
+        if (item.mesh->lodCount > 0)
+            candidates.push_back(&item);
+    }
+
+    /* padded with empty spheres for the SIMD test */
+    size_t padded = (candidates.size() + FRUSTUM_CULLING_WIDTH - 1) / FRUSTUM_CULLING_WIDTH * FRUSTUM_CULLING_WIDTH;
+    for (vector<float> &component : spheres)
+        component.assign(padded, 0.0f);
+    visible.resize(padded);
+
+    for (size_t i = 0; i < candidates.size(); i++)
+    {
+        float world[4];
+        TransformSphere(candidates[i]->model, candidates[i]->mesh->center, candidates[i]->mesh->radius, world);
+        for (int k = 0; k < 4; k++)
+            spheres[k][i] = world[k];
+    }
+
+    Frustum frustum;
+    ExtractFrustum(scene->camera.projectionMatrix, scene->camera.viewMatrix, &frustum);
+    SphereArray array = {spheres[0].data(), spheres[1].data(), spheres[2].data(), spheres[3].data(),
+                         candidates.size()};
+    visibleItems = CullSpheres(&frustum, &array, visible.data());
+    culledItems = candidates.size() - visibleItems;
+
+    size_t kept = 0;
+    for (size_t i = 0; i < candidates.size(); i++)
+        if (visible[i])
+            candidates[kept++] = candidates[i];
+    candidates.resize(kept);
+}
+
+/******************************************************************
+*
+* @brief Draws one snapshot: the parts outside the view frustum are
+* culled, the levels of detail are picked from its camera, then the
+* remaining parts go through the render queue with the program
+* variant for their features. The point lights are binned for the
+* snapshot's camera; without any in view the variants that loop
+* over clusters are not used. The light gizmos come last.
+*
+*******************************************************************/
+void RenderThread::renderFrame(const SceneSnapshot *scene)
+{
+    GLState::resetCounters();
+    ShaderProgram::resetUpdates();
+    frameUniforms->reset();
+
+    // draw scene
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    Camera::Shoot(&scene->camera, frameUniforms);
+    Light::LightUpScene(&scene->light, frameUniforms);
+    clusterBuffers->update(scene->lights, &scene->camera, frameUniforms);
+    unsigned int lightFeatures = clusterBuffers->getLights() > 0 ? SHADER_CLUSTERED_LIGHTS : 0;
+
+    /* Draw items of all arms, then all uniform data of the frame in one upload; a reused
+     * snapshot is staged again since the asset uploads may have made more meshes resident */
+    cull(scene);
+    queue->reset(scene->camera.viewMatrix);
+    for (const SnapshotItem *item : candidates)
+    {
+        int lod = SelectMeshLod(item->mesh, item->model, scene->camera.viewMatrix, scene->camera.projectionMatrix,
+                                viewportHeight);
+        /* parts whose texture is still the white placeholder skip the texture fetch */
+        unsigned int features = (assets->isTextureResident(*item->texture) ? SHADER_TEXTURED : 0) | lightFeatures;
+        queue->push({programs->select(features), item->mesh, item->texture, lod, item->model});
+    }
+    queue->stage();
+    frameUniforms->upload();
+
+    queue->draw();
+    gizmos->draw(&scene->light, scene->lights);
+}
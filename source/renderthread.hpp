@@ -0,0 +1,98 @@
+#ifndef RENDERTHREAD_H
+#define RENDERTHREAD_H
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include "utils.hpp"
+#include "scenesnapshot.hpp"
+#include "shadervariants.hpp"
+#include "uniformbuffer.hpp"
+#include "renderqueue.hpp"
+#include "clusterbuffers.hpp"
+#include "lightgizmos.hpp"
+#include "glstate.hpp"
+#include "assetregistry.hpp"
+#include "light.hpp"
+#include "FrustumCulling.hpp"
+
+using namespace std;
+
+/* Frame statistics of the render thread since the last takeStatistics() */
+typedef struct
+{
+    int frames;
+    int reusedFrames;           // frames that drew the same snapshot as the frame before
+    double snapshotAge;         // sum over all frames, in ms, from publishing to the swap
+    double maxSnapshotAge;
+    double cpuTime;             // sum over all frames, in ms
+    StreamBufferCounters fences;    // sums of the waits for regions of the streaming rings
+    /* of the last frame */
+    int visibleItems;           // resident parts inside the view frustum
+    int culledItems;
+    int pointLights;            // that reach the view frustum
+    int clusterIndices;         // light references of all clusters
+    double clusterTime;         // binning, in ms
+    int drawItems;
+    int drawCalls;
+    int drawCommands;
+    int stateRuns;
+    double sortTime;
+    GLStateCounters stateCalls;
+} RenderStatistics;
+
+/******************************************************************
+*
+* Owns the GL context while it runs: draws the latest snapshot the
+* simulation published, uploads the loaded assets between frames and
+* swaps the buffers. Polling and simulation stay on the main thread.
+*
+*******************************************************************/
+class RenderThread
+{
+private:
+    GLFWwindow *window;
+    SnapshotBuffer *snapshots;
+    AssetRegistry *assets;
+
+    ShaderVariants *programs;
+    UniformBuffer *frameUniforms;
+    RenderQueue *queue;
+    ClusterBuffers *clusterBuffers;
+    LightGizmos *gizmos;
+
+    thread worker;
+    atomic<int> stopping;
+    atomic<int> framebufferWidth;   // 0 until the window was resized
+    atomic<int> framebufferHeight;
+    int viewportHeight;             // in pixels, as last passed to glViewport
+
+    /* resident parts of the frame and their bounding spheres in world space */
+    vector<const SnapshotItem *> candidates;
+    vector<float> spheres[4];   // x, y, z, radius
+    vector<unsigned char> visible;
+    int visibleItems;
+    int culledItems;
+
+    mutex statisticsLock;
+    RenderStatistics statistics;
+
+    void run();
+
+    void cull(const SceneSnapshot *scene);
+
+    void renderFrame(const SceneSnapshot *scene);
+
+public:
+    RenderThread(GLFWwindow *window, SnapshotBuffer *snapshots, AssetRegistry *assets);
+
+    ~RenderThread();
+
+    void start();
+
+    void resize(int width, int height);
+
+    RenderStatistics takeStatistics();
+};
+
+#endif /* RENDERTHREAD_H */
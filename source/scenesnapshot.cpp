@@ -0,0 +1,43 @@
+#include "scenesnapshot.hpp"
+
+SnapshotBuffer::SnapshotBuffer() :
+        middle(1), back(2), front(0), published(0)
+{
+    for (SceneSnapshot &slot : slots)
+    {
+        memset(&slot.camera, 0, sizeof(slot.camera));
+        memset(&slot.light, 0, sizeof(slot.light));
+        slot.sequence = 0;
+        slot.time = 0;
+    }
+}
+
+/** Returns the slot the writer fills next; it keeps the data of an older snapshot */
+SceneSnapshot *SnapshotBuffer::getBack()
+{
+    return &slots[back];
+}
+
+/** Makes the back slot the latest snapshot; called by the writer */
+void SnapshotBuffer::publish()
+{
+    slots[back].sequence = ++published;
+    slots[back].time = glfwGetTime();
+    back = middle.exchange(back | SNAPSHOT_FRESH, memory_order_acq_rel) & ~SNAPSHOT_FRESH;
+}
+
+/******************************************************************
+*
+* @brief Returns the latest published snapshot; called by the reader.
+* The snapshot stays valid until the next call.
+*
+* @param fresh = set to 0 if no snapshot was published since the
+* last call, so the previous one is returned again
+*******************************************************************/
+const SceneSnapshot *SnapshotBuffer::acquire(int *fresh)
+{
+    *fresh = (middle.load(memory_order_acquire) & SNAPSHOT_FRESH) != 0;
+    if (*fresh)
+        front = middle.exchange(front, memory_order_acq_rel) & ~SNAPSHOT_FRESH;
+    return &slots[front];
+}
@@ -0,0 +1,62 @@
+#ifndef SCENESNAPSHOT_H
+#define SCENESNAPSHOT_H
+
+#include <atomic>
+#include <vector>
+#include "utils.hpp"
+#include "uniformbuffer.hpp"
+#include "LightClustering.hpp"
+
+using namespace std;
+
+/* One part of an arm as the simulation left it */
+typedef struct
+{
+    const Mesh *mesh;           // owned by the asset registry
+    const GLuint *texture;
+    float model[16];            // row-major
+} SnapshotItem;
+
+/* Everything the render thread needs to draw one simulation step */
+typedef struct
+{
+    vector<SnapshotItem> items;
+    CameraUniforms camera;
+    LightUniforms light;
+    vector<PointLight> lights;  // in world space
+    unsigned long sequence;     // 1 for the first published snapshot
+    double time;                // glfwGetTime() when it was published
+} SceneSnapshot;
+
+/******************************************************************
+*
+* Lock-free triple buffer between the simulation (the writer) and
+* the render thread (the reader). The writer fills the back slot and
+* publishes it by swapping it with the middle slot; the reader swaps
+* the middle slot with its front slot only if a newer snapshot was
+* published meanwhile. Neither side ever waits for the other, and a
+* snapshot is never changed while the reader uses it.
+*
+*******************************************************************/
+class SnapshotBuffer
+{
+private:
+    SceneSnapshot slots[3];
+    atomic<int> middle;         // slot index, SNAPSHOT_FRESH once published
+    int back;                   // owned by the writer
+    int front;                  // owned by the reader
+    unsigned long published;
+
+    static const int SNAPSHOT_FRESH = 4;
+
+public:
+    SnapshotBuffer();
+
+    SceneSnapshot *getBack();
+
+    void publish();
+
+    const SceneSnapshot *acquire(int *fresh);
+};
+
+#endif /* SCENESNAPSHOT_H */
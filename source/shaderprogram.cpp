@@ -0,0 +1,139 @@
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "shaderprogram.hpp"
+#include "utils.hpp"
+#include "uniformbuffer.hpp"
+#include "glstate.hpp"
+
+int Uniform::updates = 0;
+
+/******************************************************************
+*
+* @brief Takes over a linked program (see FinishShaderProgram) and
+* binds its uniform blocks
+*
+*******************************************************************/
+ShaderProgram::ShaderProgram(GLuint program) :
+        id(program)
+{
+    reflect();
+
+    bindBlock("CameraBlock", UNIFORM_BLOCK_CAMERA, sizeof(CameraUniforms), 1);
+    /* the light gizmos are not shaded and leave the LightBlock unused */
+    bindBlock("LightBlock", UNIFORM_BLOCK_LIGHT, sizeof(LightUniforms), 0);
+    bindBlock("ClusterBlock", UNIFORM_BLOCK_CLUSTERS, sizeof(ClusterUniforms), 0);
+
+    /* the samplers got their units with the program (see FinishShaderProgram), only their types are checked */
+    resolve("tex", GL_SAMPLER_2D, 0);
+    resolve("ClusterLights", GL_SAMPLER_BUFFER, 0);
+    resolve("ClusterRanges", GL_UNSIGNED_INT_SAMPLER_BUFFER, 0);
+    resolve("ClusterIndices", GL_UNSIGNED_INT_SAMPLER_BUFFER, 0);
+}
+
+ShaderProgram::~ShaderProgram()
+{
+    GLState::deleteProgram(id);
+}
+
+/* Queries the name, type and location of every active uniform */
+void ShaderProgram::reflect()
+{
+    GLint count = 0;
+    GLint maxLength = 0;
+    glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+    vector<GLchar> name(maxLength + 1);
+    for (GLint i = 0; i < count; i++)
+    {
+        UniformInfo info;
+        GLsizei length = 0;
+        glGetActiveUniform(id, i, name.size(), &length, &info.size, &info.type, name.data());
+
+        /* arrays are reported as "name[0]" */
+        string key(name.data(), length);
+        if (key.size() > 3 && key.compare(key.size() - 3, 3, "[0]") == 0)
+            key.resize(key.size() - 3);
+
+        info.location = glGetUniformLocation(id, name.data());
+        uniforms[key] = info;
+    }
+}
+
+/******************************************************************
+*
+* @brief Returns the location of a reflected uniform, or -1 if the
+* program does not use it. A missing required uniform or a type that
+* does not match the handle is a fatal error.
+*
+*******************************************************************/
+GLint ShaderProgram::resolve(const char *name, GLenum type, int required)
+{
+    auto found = uniforms.find(name);
+    if (found == uniforms.end())
+    {
+        if (required)
+        {
+            fprintf(stderr, "Could not bind uniform %s\n", name);
+            exit(-1);
+        }
+        return -1;
+    }
+
+    /* samplers and booleans are set with glUniform1i like ints */
+    if (found->second.type != type && !(type == GL_INT && found->second.type == GL_BOOL))
+    {
+        fprintf(stderr, "Uniform %s has type 0x%x, expected 0x%x\n", name, found->second.type, type);
+        exit(-1);
+    }
+    return found->second.location;
+}
+
+/******************************************************************
+*
+* @brief Assigns a uniform block its binding point. A required block
+* must exist, and every block must fit the C struct that is uploaded
+* for it; a mismatch means shader and UniformBuffer layouts diverged.
+*
+*******************************************************************/
+void ShaderProgram::bindBlock(const char *name, GLuint binding, size_t size, int required)
+{
+    GLuint index = glGetUniformBlockIndex(id, name);
+    if (index == GL_INVALID_INDEX && !required)
+        return;
+    if (index == GL_INVALID_INDEX)
+    {
+        fprintf(stderr, "Could not bind uniform block %s\n", name);
+        exit(-1);
+    }
+
+    GLint dataSize = 0;
+    glGetActiveUniformBlockiv(id, index, GL_UNIFORM_BLOCK_DATA_SIZE, &dataSize);
+    if ((size_t) dataSize > size)
+    {
+        fprintf(stderr, "Uniform block %s has %d bytes, expected %zu\n", name, dataSize, size);
+        exit(-1);
+    }
+
+    glUniformBlockBinding(id, index, binding);
+}
+
+GLuint ShaderProgram::getID()
+{
+    return id;
+}
+
+void ShaderProgram::use()
+{
+    GLState::useProgram(id);
+}
+
+/* Returns how many uniform values were set since the last call; each
+ * of them used to be a glGetUniformLocation by name */
+int ShaderProgram::resetUpdates()
+{
+    int updates = Uniform::updates;
+    Uniform::updates = 0;
+    return updates;
+}
@@ -0,0 +1,110 @@
+#ifndef SHADERPROGRAM_H
+#define SHADERPROGRAM_H
+
+#include <map>
+#include <string>
+#include <GL/glew.h>
+#include "Vector.hpp"
+
+using namespace std;
+
+/* Texture units of the samplers in phong.fs, set once per program (see FinishShaderProgram) */
+enum TextureUnit
+{
+    TEXTURE_UNIT_PART = 0, TEXTURE_UNIT_CLUSTER_LIGHTS = 1, TEXTURE_UNIT_CLUSTER_RANGES = 2,
+    TEXTURE_UNIT_CLUSTER_INDICES = 3
+};
+
+/* Location of a uniform, resolved once after linking; setting a uniform
+ * that the program does not use (location -1) is a no-op in GL */
+struct Uniform
+{
+    GLint location;
+
+    static int updates;     // values set since the last resetUpdates()
+};
+
+struct UniformFloat : Uniform
+{
+    void set(float value) const
+    {
+        glUniform1f(location, value);
+        updates++;
+    }
+};
+
+struct UniformInt : Uniform
+{
+    void set(int value) const
+    {
+        glUniform1i(location, value);
+        updates++;
+    }
+};
+
+struct UniformVec3 : Uniform
+{
+    void set(const float *value) const
+    {
+        glUniform3fv(location, 1, value);
+        updates++;
+    }
+
+    void set(const Vector &value) const
+    {
+        glUniform3f(location, value.x, value.y, value.z);
+        updates++;
+    }
+};
+
+/* Matrices are row-major like everything in Matrix.h */
+struct UniformMat4 : Uniform
+{
+    void set(const float *matrix) const
+    {
+        glUniformMatrix4fv(location, 1, GL_TRUE, matrix);
+        updates++;
+    }
+};
+
+/******************************************************************
+*
+* A linked shader program and the uniforms the renderer sets on it.
+* All active uniforms are queried once after linking, so drawing
+* does no lookups by name. Camera, light and object data come from
+* uniform blocks (see UniformBuffer), which are assigned their
+* binding points here.
+*
+*******************************************************************/
+class ShaderProgram
+{
+private:
+    typedef struct
+    {
+        GLint location;
+        GLenum type;
+        GLint size;
+    } UniformInfo;
+
+    GLuint id;
+    map<string, UniformInfo> uniforms;
+
+    void reflect();
+
+    GLint resolve(const char *name, GLenum type, int required);
+
+    void bindBlock(const char *name, GLuint binding, size_t size, int required);
+
+public:
+    explicit ShaderProgram(GLuint program);
+
+    ~ShaderProgram();
+
+    GLuint getID();
+
+    void use();
+
+    static int resetUpdates();
+};
+
+#endif /* SHADERPROGRAM_H */
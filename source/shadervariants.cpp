@@ -0,0 +1,107 @@
+#include <cstdio>
+#include "shadervariants.hpp"
+#include <GLFW/glfw3.h>
+#include "ShaderPreprocessor.hpp"
+#include "utils.hpp"
+
+/* KHR_parallel_shader_compile is newer than the bundled GLEW */
+#ifndef GL_MAX_SHADER_COMPILER_THREADS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#endif
+
+typedef void (GLAPIENTRY *MaxShaderCompilerThreadsProc)(GLuint count);
+
+/* #defines of the features, in the order of their bits */
+static const char *featureNames[SHADER_FEATURE_COUNT] = {"TEXTURED", "CLUSTERED_LIGHTS"};
+
+int ShaderVariants::parallelSupport = -1;
+
+/** Lets the driver compile on all threads it has, once; needs a current GL context */
+int ShaderVariants::enableParallelCompile()
+{
+    if (parallelSupport < 0)
+    {
+        MaxShaderCompilerThreadsProc maxThreads = nullptr;
+        if (glfwExtensionSupported("GL_KHR_parallel_shader_compile"))
+            maxThreads = (MaxShaderCompilerThreadsProc) glfwGetProcAddress("glMaxShaderCompilerThreadsKHR");
+        else if (glfwExtensionSupported("GL_ARB_parallel_shader_compile"))
+            maxThreads = (MaxShaderCompilerThreadsProc) glfwGetProcAddress("glMaxShaderCompilerThreadsARB");
+
+        /* 0xffffffff: as many threads as the implementation likes */
+        if (maxThreads != nullptr)
+            maxThreads(0xffffffff);
+        parallelSupport = maxThreads != nullptr;
+    }
+    return parallelSupport;
+}
+
+/* Returns the #define lines of a combination of features */
+string ShaderVariants::defines(unsigned int features)
+{
+    string lines;
+    for (int f = 0; f < SHADER_FEATURE_COUNT; f++)
+    {
+        if (features & (1u << f))
+            lines += string("#define ") + featureNames[f] + " 1\n";
+    }
+    return lines;
+}
+
+/******************************************************************
+*
+* @brief Builds a program for every combination of 'features' from
+* a vertex and a fragment shader file; needs a current GL context.
+* Variants come from the binary cache where possible, the others
+* compile side by side and are checked once all are submitted.
+*
+*******************************************************************/
+ShaderVariants::ShaderVariants(const string &vsPath, const string &fsPath, unsigned int _features) :
+        programs{}, features(_features), count(0)
+{
+    int parallel = enableParallelCompile();
+    double start = glfwGetTime();
+
+    PendingProgram pending[1 << SHADER_FEATURE_COUNT];
+    for (unsigned int variant = 0; variant < (1u << SHADER_FEATURE_COUNT); variant++)
+    {
+        if ((variant & features) != variant)
+            continue;
+
+        string variantDefines = defines(variant);
+        pending[variant] = BeginShaderProgram(PreprocessShader(vsPath, variantDefines),
+                                              PreprocessShader(fsPath, variantDefines), variantDefines);
+        count++;
+    }
+
+    /* the compiles overlap, so each program is only charged the time since the one before finished */
+    for (unsigned int variant = 0; variant < (1u << SHADER_FEATURE_COUNT); variant++)
+    {
+        if ((variant & features) != variant)
+            continue;
+
+        pending[variant].start = start;
+        programs[variant] = new ShaderProgram(FinishShaderProgram(&pending[variant]));
+        start = glfwGetTime();
+    }
+
+    printf("Shader variants: %d programs from %s and %s, %s\n", count, vsPath.c_str(), fsPath.c_str(),
+           parallel ? "compiled in parallel (parallel shader compile)" : "compiled by the driver's own schedule");
+}
+
+ShaderVariants::~ShaderVariants()
+{
+    for (ShaderProgram *program : programs)
+        delete program;
+}
+
+/** Returns the variant for a combination of features; features no variant was built for are ignored */
+ShaderProgram *ShaderVariants::select(unsigned int wanted)
+{
+    return programs[wanted & features];
+}
+
+/** Returns how many variants were built */
+int ShaderVariants::getCount()
+{
+    return count;
+}
@@ -0,0 +1,54 @@
+#ifndef SHADERVARIANTS_H
+#define SHADERVARIANTS_H
+
+#include <string>
+#include <GL/glew.h>
+#include "shaderprogram.hpp"
+
+using namespace std;
+
+/* Features a program can be specialized for; each is a #define of the same name in the shaders */
+enum ShaderFeature
+{
+    SHADER_TEXTURED = 1 << 0, SHADER_CLUSTERED_LIGHTS = 1 << 1
+};
+
+#define SHADER_FEATURE_COUNT 2
+
+/******************************************************************
+*
+* The programs built from one pair of shader files for every
+* combination of a set of features. Each variant is preprocessed
+* with its own #defines, so a feature costs nothing in the shaders
+* of the variants without it; the renderer selects the variant per
+* draw item instead of branching on uniforms.
+*
+* All variants are handed to the driver before any is checked, and
+* with KHR_parallel_shader_compile (or ARB_parallel_shader_compile)
+* the driver is asked to compile them on as many threads as it has.
+*
+*******************************************************************/
+class ShaderVariants
+{
+private:
+    ShaderProgram *programs[1 << SHADER_FEATURE_COUNT];   // by features, null if not built
+    unsigned int features;      // that the variants differ in
+    int count;
+
+    static int parallelSupport; // -1 until detected
+
+    static int enableParallelCompile();
+
+    static string defines(unsigned int features);
+
+public:
+    ShaderVariants(const string &vsPath, const string &fsPath, unsigned int features);
+
+    ~ShaderVariants();
+
+    ShaderProgram *select(unsigned int features);
+
+    int getCount();
+};
+
+#endif /* SHADERVARIANTS_H */
@@ -0,0 +1,171 @@
+#include <cstdio>
+#include "streambuffer.hpp"
+#include <GLFW/glfw3.h>
+#include "glstate.hpp"
+
+/* ARB_buffer_storage is newer than the bundled GLEW */
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+
+typedef void (GLAPIENTRY *BufferStorageProc)(GLenum target, GLsizeiptr size, const void *data, GLbitfield flags);
+
+static BufferStorageProc bufferStorage = nullptr;
+
+int StreamBuffer::storageSupport = -1;
+StreamBufferCounters StreamBuffer::counters = {0, 0, 0};
+
+/** Looks up glBufferStorage once; needs a current GL context */
+int StreamBuffer::hasBufferStorage()
+{
+    if (storageSupport < 0)
+    {
+        GLint major = 0, minor = 0;
+        glGetIntegerv(GL_MAJOR_VERSION, &major);
+        glGetIntegerv(GL_MINOR_VERSION, &minor);
+
+        if (major > 4 || (major == 4 && minor >= 4) || glfwExtensionSupported("GL_ARB_buffer_storage"))
+            bufferStorage = (BufferStorageProc) glfwGetProcAddress("glBufferStorage");
+        storageSupport = bufferStorage != nullptr;
+
+        printf("Streaming buffers: %s\n", storageSupport ? "persistently mapped (buffer storage)" :
+                                          "mapped per frame, unsynchronized with fences");
+    }
+    return storageSupport;
+}
+
+/** Creates the ring; needs a current GL context */
+StreamBuffer::StreamBuffer(size_t _regionSize, size_t _alignment) :
+        buffer(0), regionSize(0), alignment(_alignment), region(-1), mapped(0), persistent(nullptr),
+        fences{}
+{
+    create(_regionSize);
+}
+
+StreamBuffer::~StreamBuffer()
+{
+    destroy();
+}
+
+/** Creates the buffer with regions of at least 'size' bytes */
+void StreamBuffer::create(size_t size)
+{
+    regionSize = (size + alignment - 1) / alignment * alignment;
+    size_t total = regionSize * STREAM_BUFFER_FRAMES;
+
+    glGenBuffers(1, &buffer);
+    GLState::bindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    if (hasBufferStorage())
+    {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        bufferStorage(GL_COPY_WRITE_BUFFER, total, nullptr, flags);
+        persistent = (unsigned char *) glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, total, flags);
+    } else
+    {
+        glBufferData(GL_COPY_WRITE_BUFFER, total, nullptr, GL_STREAM_DRAW);
+    }
+}
+
+/** Waits until the GPU is done with all regions and deletes the buffer */
+void StreamBuffer::destroy()
+{
+    for (int i = 0; i < STREAM_BUFFER_FRAMES; i++)
+        wait(i);
+
+    if (persistent != nullptr || mapped)
+    {
+        GLState::bindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        persistent = nullptr;
+        mapped = 0;
+    }
+    GLState::deleteBuffer(buffer);
+}
+
+/** Waits for the fence of a region, if there is one, and counts the wait if the GPU was not done */
+void StreamBuffer::wait(int index)
+{
+    if (fences[index] == nullptr)
+        return;
+
+    if (glClientWaitSync(fences[index], 0, 0) == GL_TIMEOUT_EXPIRED)
+    {
+        double start = glfwGetTime();
+        GLenum status;
+        do
+        {
+            status = glClientWaitSync(fences[index], GL_SYNC_FLUSH_COMMANDS_BIT, STREAM_BUFFER_WAIT_STEP);
+        } while (status == GL_TIMEOUT_EXPIRED);
+        counters.waits++;
+        counters.waitTime += (glfwGetTime() - start) * 1000.0;
+    }
+
+    glDeleteSync(fences[index]);
+    fences[index] = nullptr;
+}
+
+/******************************************************************
+*
+* @brief Moves on to the next region and returns it for writing
+* 'size' bytes; called once per frame, before any draw reads the
+* data. The previous region is fenced here, as everything that used
+* it has been submitted by now. A ring that is too small grows,
+* which changes getBuffer().
+*
+*******************************************************************/
+void *StreamBuffer::map(size_t size)
+{
+    unmap();
+    if (region >= 0)
+        fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+    if (size > regionSize)
+    {
+        destroy();
+        create(size > 2 * regionSize ? size : 2 * regionSize);
+        counters.reallocations++;
+    }
+
+    region = (region + 1) % STREAM_BUFFER_FRAMES;
+    wait(region);
+
+    if (persistent != nullptr)
+        return persistent + getOffset();
+
+    GLState::bindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    void *data = glMapBufferRange(GL_COPY_WRITE_BUFFER, getOffset(), regionSize,
+                                  GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+    mapped = 1;
+    return data;
+}
+
+/** Ends the writes to the current region; draws may read it afterwards */
+void StreamBuffer::unmap()
+{
+    if (!mapped)
+        return;
+
+    GLState::bindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+    mapped = 0;
+}
+
+GLuint StreamBuffer::getBuffer()
+{
+    return buffer;
+}
+
+/** Returns the offset of the current region in the buffer */
+size_t StreamBuffer::getOffset()
+{
+    return region < 0 ? 0 : region * regionSize;
+}
+
+/** Returns the fence waits since the last call */
+StreamBufferCounters StreamBuffer::resetCounters()
+{
+    StreamBufferCounters previous = counters;
+    counters = {0, 0, 0};
+    return previous;
+}
@@ -0,0 +1,72 @@
+#ifndef STREAMBUFFER_H
+#define STREAMBUFFER_H
+
+#include <cstddef>
+#include <GL/glew.h>
+
+/* Frames whose data may be in flight at once; each gets its own region of the ring */
+#define STREAM_BUFFER_FRAMES 3
+
+/* Time to wait for a fence before checking it again, in nanoseconds */
+#define STREAM_BUFFER_WAIT_STEP 1000000
+
+/* Fences the CPU had to wait for, i.e. frames the GPU was still using */
+typedef struct
+{
+    int waits;
+    double waitTime;            // in ms
+    int reallocations;          // rings that had to grow
+} StreamBufferCounters;
+
+/******************************************************************
+*
+* Ring of STREAM_BUFFER_FRAMES regions in one buffer for data that
+* is written once per frame. Each frame maps the next region; the
+* fence placed after the region's previous use tells whether the GPU
+* still reads it, so the CPU only waits when it is frames ahead.
+*
+* With ARB_buffer_storage (or GL 4.4) the buffer is mapped once,
+* persistently and coherently. Otherwise each region is mapped
+* unsynchronized for the frame and unmapped before drawing; the
+* fences keep this safe as well.
+*
+*******************************************************************/
+class StreamBuffer
+{
+private:
+    GLuint buffer;
+    size_t regionSize;
+    size_t alignment;
+    int region;                 // region of the current frame, -1 before the first
+    int mapped;                 // the current region is mapped (per frame mapping only)
+    unsigned char *persistent;  // start of the buffer, nullptr without buffer storage
+    GLsync fences[STREAM_BUFFER_FRAMES];
+
+    static int storageSupport;  // -1 until detected
+    static StreamBufferCounters counters;
+
+    static int hasBufferStorage();
+
+    void create(size_t size);
+
+    void destroy();
+
+    void wait(int index);
+
+public:
+    StreamBuffer(size_t regionSize, size_t alignment);
+
+    ~StreamBuffer();
+
+    void *map(size_t size);
+
+    void unmap();
+
+    GLuint getBuffer();
+
+    size_t getOffset();
+
+    static StreamBufferCounters resetCounters();
+};
+
+#endif /* STREAMBUFFER_H */
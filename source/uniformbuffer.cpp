@@ -0,0 +1,72 @@
+#include <cstring>
+#include "uniformbuffer.hpp"
+#include "glstate.hpp"
+
+/** Creates the ring; needs a current GL context */
+UniformBuffer::UniformBuffer()
+{
+    GLint align = 0;
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &align);
+    alignment = align > 0 ? align : 256;
+
+    ring = new StreamBuffer(UNIFORM_BUFFER_FRAME_BYTES, alignment);
+}
+
+UniformBuffer::~UniformBuffer()
+{
+    delete ring;
+}
+
+/** Starts collecting the blocks of a new frame */
+void UniformBuffer::reset()
+{
+    staging.clear();
+    ranges.clear();
+}
+
+/******************************************************************
+*
+* @brief Copies a block into the frame's data
+*
+* @return offset of the block, a multiple of
+* GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+*******************************************************************/
+size_t UniformBuffer::append(const void *data, size_t size)
+{
+    size_t offset = (staging.size() + alignment - 1) / alignment * alignment;
+    staging.resize(offset + size);
+    memcpy(staging.data() + offset, data, size);
+    return offset;
+}
+
+/* Copies the frame's data into the next region of the ring and
+ * binds the blocks there; regions still read by earlier frames are
+ * left alone */
+void UniformBuffer::upload()
+{
+    memcpy(ring->map(staging.size()), staging.data(), staging.size());
+    ring->unmap();
+
+    for (const BlockRange &range : ranges)
+    {
+        GLState::bindBufferRange(GL_UNIFORM_BUFFER, range.binding, ring->getBuffer(),
+                                 ring->getOffset() + range.offset, range.size);
+    }
+}
+
+/** Makes the block at 'offset' the source of the uniform block at 'binding', from upload() on */
+void UniformBuffer::bind(GLuint binding, size_t offset, size_t size)
+{
+    ranges.push_back({binding, offset, size});
+}
+
+/** Returns the size of the frame's data in bytes */
+size_t UniformBuffer::getSize()
+{
+    return staging.size();
+}
+
+int UniformBuffer::getBinds()
+{
+    return ranges.size();
+}
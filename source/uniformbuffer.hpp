@@ -0,0 +1,88 @@
+#ifndef UNIFORMBUFFER_H
+#define UNIFORMBUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <GL/glew.h>
+#include "streambuffer.hpp"
+
+using namespace std;
+
+/* Initial size of a frame's uniform data; the ring grows when a frame needs more */
+#define UNIFORM_BUFFER_FRAME_BYTES 4096
+
+/* Binding points of the uniform blocks in phong.vs / phong.fs */
+enum UniformBlockBinding
+{
+    UNIFORM_BLOCK_CAMERA = 0, UNIFORM_BLOCK_LIGHT = 1, UNIFORM_BLOCK_CLUSTERS = 2
+};
+
+/* std140 layouts of the blocks; matrices are row-major as in Matrix.h
+ * (the blocks are declared row_major), vec3 members take a vec4 */
+typedef struct
+{
+    float projectionMatrix[16];
+    float viewMatrix[16];
+} CameraUniforms;
+
+typedef struct
+{
+    float position[4];
+    float color[4];
+    float ambient;
+    float diffuse;
+    float specular;
+    float padding;
+} LightUniforms;
+
+/* Grid and buffer offsets of the clustered point lights (see ClusterBuffers) */
+typedef struct
+{
+    float depth[4];             // near plane, depth slices per unit of log(depth / near plane), unused
+    int32_t size[4];            // clusters in x, y and z, lights
+    int32_t offsets[4];         // first texel of the frame's lights, cluster ranges and indices, unused
+} ClusterUniforms;
+
+/******************************************************************
+*
+* Collects the uniform block data of a frame in one buffer: blocks
+* are appended at offsets aligned for glBindBufferRange, the whole
+* frame is copied into the next region of a streaming ring at once
+* and each draw only selects its range.
+*
+*******************************************************************/
+class UniformBuffer
+{
+private:
+    typedef struct
+    {
+        GLuint binding;
+        size_t offset;      // within the frame's data
+        size_t size;
+    } BlockRange;
+
+    StreamBuffer *ring;
+    size_t alignment;
+    vector<unsigned char> staging;
+    vector<BlockRange> ranges;  // bound by upload(), once the region is known
+
+public:
+    UniformBuffer();
+
+    ~UniformBuffer();
+
+    void reset();
+
+    size_t append(const void *data, size_t size);
+
+    void upload();
+
+    void bind(GLuint binding, size_t offset, size_t size);
+
+    size_t getSize();
+
+    int getBinds();
+};
+
+#endif /* UNIFORMBUFFER_H */
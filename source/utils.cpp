@@ -1,135 +1,172 @@
 #include "utils.hpp"
-#include "OBJParser.hpp"            /* Loading function for triangle meshes in OBJ format */
 #include "LoadTexture.hpp"
+#include "glstate.hpp"
+#include "programcache.hpp"
+#include "shaderprogram.hpp"
 
 /******************************************************************
 *
-* @brief This function read the content of an OBJ file and then fill the
-* buffer objects with the data
+* @brief This function loads the streams of an OBJ file, from the
+* binary mesh cache when it is up to date (otherwise they are built
+* and reordered for the vertex cache, see MeshOptimizer), and then
+* copies the data into ranges of the geometry pool
 *
 * @param filename = name of mesh file
 * @param scale = scale factor applied to the vertices
-* @param NBO = reference to normals buffer object
-* @param VAO = reference to VAO
+* @param mesh = receives pool ranges, VAO and index format
 *******************************************************************/
-void readMeshFile(string filename, float scale, GLuint *NBO, GLuint *VAO)
+void readMeshFile(string filename, float scale, GeometryPool *pool, Mesh *mesh)
 {
-    GLuint VBO;
-    GLuint IBO;
-    GLuint UVBO;
+    /* Streams are either mapped from the cache or rebuilt into data */
+    MeshData data;
+    MeshView view;
 
-    /* Structure for loading of OBJ data */
-    obj_scene_data data;
-
-    /* Load first OBJ model */
-    int success = parse_obj_scene(&data, filename.c_str());
-
-    if (!success)
+    if (!LoadMesh(filename, scale, &DefaultMeshImportOptions, &data, &view))
+    {
         printf("Could not load file. Exiting.\n");
+        exit(-1);
+    }
 
-    /*  Copy mesh data from structs into appropriate arrays */
-    int indx = data.face_count;
-
-    auto *index_buffer_data = (GLushort *) calloc(indx * 3, sizeof(GLushort));
-    auto *vertex_buffer_data = (GLfloat *) calloc(indx * 9, sizeof(GLfloat));
-    auto *normal_buffer_data = (GLfloat *) calloc(indx * 9, sizeof(GLfloat));
-    auto *uv_buffer_data = (GLfloat *) calloc(indx * 6, sizeof(GLfloat));
-
-    /* for each triangle... */
-    for (int i = 0; i < indx; i++)
-    {
-        int offset3D = i * 9;
-        int offset2D = i * 6;
+    SetupMeshParameters(filename, &view, mesh);
 
-        /* fill VBO for this triangle (x,y,z coords for 3 vertices = 9 values) */
-        for (int j = 0; j < 3; j++)
-        {
-            /* Index of current vertex */
-            int idVert = (GLushort) (*data.face_list[i]).vertex_index[j];
-            vertex_buffer_data[offset3D + j * 3] = (GLfloat) (*data.vertex_list[idVert]).e[0] * scale;
-            vertex_buffer_data[offset3D + j * 3 + 1] = (GLfloat) (*data.vertex_list[idVert]).e[1] * scale;
-            vertex_buffer_data[offset3D + j * 3 + 2] = (GLfloat) (*data.vertex_list[idVert]).e[2] * scale;
-        }
+    /* Reserve ranges in the pool and load data into them */
+    pool->allocate(mesh, view.vertexFormat, view.vertexStride, view.vertexCount, view.indexSize, view.indexCount);
+    pool->upload(mesh, 1, 0, (size_t) view.vertexCount * view.vertexStride, view.vertices);
+    pool->upload(mesh, 0, 0, (size_t) view.indexCount * view.indexSize, view.indices);
 
-        /* fill Normal buffer for this triangle */
-        if ((*data.face_list[i]).normal_index[0] != -1)
-        {
-            for (int j = 0; j < 3; j++)
-            {
-                int idNorm = (GLushort) (*data.face_list[i]).normal_index[j];
-                normal_buffer_data[offset3D + j * 3] = (GLfloat) (*data.vertex_normal_list[idNorm]).e[0];
-                normal_buffer_data[offset3D + j * 3 + 1] = (GLfloat) (*data.vertex_normal_list[idNorm]).e[1];
-                normal_buffer_data[offset3D + j * 3 + 2] = (GLfloat) (*data.vertex_normal_list[idNorm]).e[2];
-            }
-        } else
-        {
-            for (int j = 0; j < 3; j++)
-            {
-                normal_buffer_data[offset3D + j * 3] = vertex_buffer_data[offset3D + j * 3];
-                normal_buffer_data[offset3D + j * 3 + 1] = vertex_buffer_data[offset3D + j * 3 + 1];
-                normal_buffer_data[offset3D + j * 3 + 2] = vertex_buffer_data[offset3D + j * 3 + 2];
-            }
-        }
+    CloseMeshView(&view);
+}
 
-        /* fill UV buffer for this triangle */
-        if ((*data.face_list[i]).texture_index[0] != -1)
-        {
-            for (int j = 0; j < 3; j++)
-            {
-                int idUV = (GLushort) (*data.face_list[i]).texture_index[j];
-                uv_buffer_data[offset2D + j * 2] = (GLfloat) (*data.vertex_texture_list[idUV]).e[0];
-                uv_buffer_data[offset2D + j * 2 + 1] = (GLfloat) (*data.vertex_texture_list[idUV]).e[1];
-            }
-        }
+/******************************************************************
+*
+* @brief Copies the draw parameters of a loaded mesh (index format,
+* levels of detail, bounding sphere, position decoding) into 'mesh';
+* no GL calls are made
+*
+*******************************************************************/
+void SetupMeshParameters(const string &filename, const MeshView *view, Mesh *mesh)
+{
+    /* a de-indexed mesh would need one vertex per index of its base level; the
+     * index count of the view covers the ranges of all levels of detail */
+    uint32_t baseIndices = view->lods[0].indexCount;
+    size_t indexedBytes = view->vertexCount * view->vertexStride + view->indexCount * view->indexSize;
+    size_t deindexedBytes = (size_t) baseIndices * view->vertexStride + (size_t) baseIndices * view->indexSize;
+    printf("Mesh %s: %u vertices (%u de-indexed), %u byte vertices, %u bit indices, "
+           "%zu KB GPU memory (%zu KB de-indexed)\n", filename.c_str(), view->vertexCount, baseIndices,
+           view->vertexStride, view->indexSize * 8, indexedBytes / 1024, deindexedBytes / 1024);
+
+    mesh->indexType = view->indexSize == sizeof(GLushort) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    mesh->gpuBytes = indexedBytes;
+    memcpy(mesh->positionScale, view->positionScale, sizeof(mesh->positionScale));
+    memcpy(mesh->positionBias, view->positionBias, sizeof(mesh->positionBias));
+
+    mesh->lodCount = view->lodCount;
+    printf("Mesh %s: levels of detail", filename.c_str());
+    for (uint32_t l = 0; l < view->lodCount; l++)
+    {
+        mesh->lods[l].indexCount = view->lods[l].indexCount;
+        mesh->lods[l].indexOffset = (GLintptr) view->lods[l].indexOffset * view->indexSize;
+        mesh->lods[l].error = view->lods[l].error;
+        printf(" %u", view->lods[l].indexCount / 3);
+    }
+    printf(" triangles\n");
 
-        /* Fill indices buffer for this triangles (3 indices) */
-        index_buffer_data[i * 3] = i * 3;
-        index_buffer_data[i * 3 + 1] = i * 3 + 1;
-        index_buffer_data[i * 3 + 2] = i * 3 + 2;
+    float diagonal = 0;
+    for (int k = 0; k < 3; k++)
+    {
+        mesh->center[k] = (view->boundsMin[k] + view->boundsMax[k]) * 0.5f;
+        diagonal += (view->boundsMax[k] - view->boundsMin[k]) * (view->boundsMax[k] - view->boundsMin[k]);
     }
+    mesh->radius = sqrtf(diagonal) * 0.5f;
+}
 
+/******************************************************************
+*
+* @brief Sets up a VAO for meshes of one vertex format in VBO and IBO
+*
+* @param vertexFormat = MESH_VERTEX_FLOAT or MESH_VERTEX_QUANTIZED
+* @param stride = bytes per vertex
+*******************************************************************/
+void SetupMeshVertexArray(GLuint VAO, GLuint VBO, GLuint IBO, uint32_t vertexFormat, GLsizei stride)
+{
+    GLState::bindVertexArray(VAO);
 
-    /* Create buffer objects and load data into buffers*/
-    glGenBuffers(1, &VBO);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, data.face_count * 9 * sizeof(GLfloat), vertex_buffer_data, GL_STATIC_DRAW);
+    /* All attributes come from the interleaved vertex buffer */
+    GLState::bindBuffer(GL_ARRAY_BUFFER, VBO);
+    glEnableVertexAttribArray(vPosition);
+    glEnableVertexAttribArray(vNormal);
+    glEnableVertexAttribArray(vUV);
 
-    glGenBuffers(1, NBO);
-    glBindBuffer(GL_ARRAY_BUFFER, *NBO);
-    glBufferData(GL_ARRAY_BUFFER, data.face_count * 9 * sizeof(GLfloat), normal_buffer_data, GL_STATIC_DRAW);
+    if (vertexFormat == MESH_VERTEX_QUANTIZED)
+    {
+        /* positions stay integers, the instance's scale and bias map them back into the bounds */
+        glVertexAttribPointer(vPosition, 3, GL_SHORT, GL_FALSE, stride,
+                              (void *) offsetof(MeshVertexQuantized, position));
+        glVertexAttribPointer(vNormal, 2, GL_SHORT, GL_TRUE, stride, (void *) offsetof(MeshVertexQuantized, normal));
+        glVertexAttribPointer(vUV, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void *) offsetof(MeshVertexQuantized, uv));
+    } else
+    {
+        glVertexAttribPointer(vPosition, 3, GL_FLOAT, GL_FALSE, stride, (void *) offsetof(MeshVertexFloat, position));
+        glVertexAttribPointer(vNormal, 2, GL_FLOAT, GL_FALSE, stride, (void *) offsetof(MeshVertexFloat, normal));
+        glVertexAttribPointer(vUV, 2, GL_FLOAT, GL_FALSE, stride, (void *) offsetof(MeshVertexFloat, uv));
+    }
 
-    glGenBuffers(1, &UVBO);
-    glBindBuffer(GL_ARRAY_BUFFER, UVBO);
-    glBufferData(GL_ARRAY_BUFFER, data.face_count * 6 * sizeof(GLfloat), uv_buffer_data, GL_STATIC_DRAW);
+    /* Model matrix rows and position decoding, advanced per instance;
+     * the pointers are set by RenderQueue */
+    for (int attribute = vInstance; attribute <= vInstanceBias; attribute++)
+    {
+        glEnableVertexAttribArray(attribute);
+        glVertexAttribDivisor(attribute, 1);
+    }
 
-    glGenBuffers(1, &IBO);
+    /* Bind index buffer */
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, data.face_count * 3 * sizeof(GLushort), index_buffer_data, GL_STATIC_DRAW);
 
+    GLState::bindVertexArray(0);
+}
 
-    /* Generate vertex array object and fill it with VBO, CBO and IBO previously written*/
-    glGenVertexArrays(1, VAO);
-    glBindVertexArray(*VAO);
+/******************************************************************
+*
+* @brief Picks the coarsest level of detail of a mesh whose error,
+* projected at the distance of the mesh, stays below
+* MESH_LOD_PIXEL_ERROR pixels; meshes that cover much of the screen
+* therefore get the full level
+*
+* @param model = model matrix of the mesh
+* @param view = view matrix of the camera
+* @param projection = projection matrix of the camera
+* @param viewportHeight = height of the viewport in pixels
+*******************************************************************/
+int SelectMeshLod(const Mesh *mesh, const float *model, const float *view, const float *projection,
+                  float viewportHeight)
+{
+    /* bounding sphere in world space; matrices are row major */
+    float world[3];
+    float scale = 0;
+    for (int r = 0; r < 3; r++)
+    {
+        world[r] = model[r * 4] * mesh->center[0] + model[r * 4 + 1] * mesh->center[1] +
+                   model[r * 4 + 2] * mesh->center[2] + model[r * 4 + 3];
 
-    /* Bind buffer with vertex data of currently active object */
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glEnableVertexAttribArray(vPosition);
-    glVertexAttribPointer(vPosition, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+        float column = sqrtf(model[r] * model[r] + model[4 + r] * model[4 + r] + model[8 + r] * model[8 + r]);
+        if (column > scale)
+            scale = column;
+    }
 
-    /* Bind normal buffer */
-    glEnableVertexAttribArray(vNormal);
-    glBindBuffer(GL_ARRAY_BUFFER, *NBO);
-    glVertexAttribPointer(vNormal, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+    /* distance in front of the camera to the nearest point of the sphere */
+    float depth = -(view[8] * world[0] + view[9] * world[1] + view[10] * world[2] + view[11]);
+    float distance = depth - mesh->radius * scale;
+    if (distance <= 0)
+        return 0;
 
-    /* Bind uv buffer */
-    glEnableVertexAttribArray(vUV);
-    glBindBuffer(GL_ARRAY_BUFFER, UVBO);
-    glVertexAttribPointer(vUV, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+    float pixelsPerUnit = projection[5] * viewportHeight * 0.5f / distance;
 
-    /* Bind index buffer */
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
+    int lod = 0;
+    for (int l = 1; l < mesh->lodCount; l++)
+        if (mesh->lods[l].error * scale * pixelsPerUnit <= MESH_LOD_PIXEL_ERROR)
+            lod = l;
 
-    glBindVertexArray(0);
+    return lod;
 }
 
 /******************************************************************
@@ -159,7 +196,7 @@ void SetupTexture(GLuint *TextureID, const char *filename)
     glGenTextures(1, TextureID);
 
     /* Bind texture */
-    glBindTexture(GL_TEXTURE_2D, *TextureID);
+    GLState::bindTexture(GL_TEXTURE_2D, *TextureID);
 
     /* Load texture image into memory */
     glTexImage2D(GL_TEXTURE_2D,     /* Target texture */
@@ -172,8 +209,15 @@ void SetupTexture(GLuint *TextureID, const char *filename)
                  GL_UNSIGNED_BYTE,  /* Type of pixel data, one byte per channel */
                  Texture->data);    /* Pointer to image data  */
 
-    /* Next set up texturing parameters */
+    SetupTextureParameters();
+
+    /* Note: MIP mapping not visible due to fixed, i.e. static camera */
+
+}
 
+/* Sets wrapping and filtering of the bound texture once its image is loaded, and builds its MIP maps */
+void SetupTextureParameters()
+{
     /* Repeat texture on edges when tiling */
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
@@ -184,18 +228,18 @@ void SetupTexture(GLuint *TextureID, const char *filename)
     /* Trilinear MIP mapping for minification */
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
     glGenerateMipmap(GL_TEXTURE_2D);
-
-    /* Note: MIP mapping not visible due to fixed, i.e. static camera */
-
 }
 
 
 /******************************************************************
 *
-* @brief This function creates and adds individual shaders
+* @brief This function creates and adds individual shaders. The
+* compile status is not queried here, so that the driver may compile
+* in the background; FinishShaderProgram reports errors.
 *
+* @return the shader object, attached to the program
 *******************************************************************/
-void AddShader(GLuint UsedShaderProgram, const char *ShaderCode, GLenum ShaderType)
+GLuint AddShader(GLuint UsedShaderProgram, const char *ShaderCode, GLenum ShaderType)
 {
     /* Create shader object */
     GLuint ShaderObj = glCreateShader(ShaderType);
@@ -209,68 +253,116 @@ void AddShader(GLuint UsedShaderProgram, const char *ShaderCode, GLenum ShaderTy
     /* Associate shader source code string with shader object */
     glShaderSource(ShaderObj, 1, &ShaderCode, nullptr);
 
-    GLint success = 0;
-    GLchar InfoLog[1024];
-
     /* Compile shader source code */
     glCompileShader(ShaderObj);
-    glGetShaderiv(ShaderObj, GL_COMPILE_STATUS, &success);
-
-    if (!success)
-    {
-        glGetShaderInfoLog(ShaderObj, 1024, nullptr, InfoLog);
-        fprintf(stderr, "Error compiling shader type %d: '%s'\n", ShaderType, InfoLog);
-        exit(1);
-    }
 
     /* Associate shader with shader program */
     glAttachShader(UsedShaderProgram, ShaderObj);
+    return ShaderObj;
 }
 
 /******************************************************************
 *
-* @brief This function creates the shader program; vertex and fragment
-* shaders are loaded and linked into program; final shader program
-* is put into the rendering pipeline
+* @brief Starts creating a shader program from preprocessed vertex
+* and fragment shader sources (see PreprocessShader). A binary of
+* the program from an earlier start is used if the sources and the
+* driver did not change (see ProgramCache); otherwise the shaders
+* are compiled and linked without waiting for the result, so several
+* programs can be in the driver's hands at once.
 *
+* @param defines = the #defines the sources were specialized with
 *******************************************************************/
-GLuint CreateShaderProgram(string vsPath, string fsPath)
+PendingProgram BeginShaderProgram(const string &vertexSource, const string &fragmentSource, const string &defines)
 {
-    GLuint ShaderProgram = glCreateProgram();
-    if (ShaderProgram == 0)
+    PendingProgram pending = {0, {0, 0}, 0, glfwGetTime()};
+
+    pending.key = ProgramCache::key(vertexSource, fragmentSource, defines);
+    pending.program = ProgramCache::load(pending.key);
+    if (pending.program != 0)
+        return pending;
+
+    pending.program = glCreateProgram();
+    if (pending.program == 0)
     {
         fprintf(stderr, "Error creating shader program\n");
         exit(1);
     }
 
-    /* Strings for loading and storing shader code */
-    const char *VertexShaderString;
-    const char *FragmentShaderString;
+    /* Separately add vertex and fragment shader to program */
+    pending.shaders[0] = AddShader(pending.program, vertexSource.c_str(), GL_VERTEX_SHADER);
+    pending.shaders[1] = AddShader(pending.program, fragmentSource.c_str(), GL_FRAGMENT_SHADER);
 
-    /* Load shader code from file */
-    VertexShaderString = LoadShader(vsPath.c_str());
-    FragmentShaderString = LoadShader(fsPath.c_str());
+    /* Link shader code into executable shader program */
+    ProgramCache::prepare(pending.program);
+    glLinkProgram(pending.program);
+    return pending;
+}
 
-    /* Separately add vertex and fragment shader to program */
-    AddShader(ShaderProgram, VertexShaderString, GL_VERTEX_SHADER);
-    AddShader(ShaderProgram, FragmentShaderString, GL_FRAGMENT_SHADER);
+/* Samplers of the shaders and the texture units they are bound to */
+static const struct
+{
+    const char *name;
+    GLint unit;
+} samplerUnits[] = {
+    {"tex", TEXTURE_UNIT_PART}, {"ClusterLights", TEXTURE_UNIT_CLUSTER_LIGHTS},
+    {"ClusterRanges", TEXTURE_UNIT_CLUSTER_RANGES}, {"ClusterIndices", TEXTURE_UNIT_CLUSTER_INDICES}
+};
+
+/* Binds the samplers of a linked program to their units once; the units are program state */
+static void SetSamplerUnits(GLuint program)
+{
+    GLState::useProgram(program);
+    for (const auto &sampler : samplerUnits)
+        glUniform1i(glGetUniformLocation(program, sampler.name), sampler.unit);
+}
+
+/******************************************************************
+*
+* @brief Waits for a program from BeginShaderProgram and checks it;
+* a shader that does not compile or a program that does not link
+* is a fatal error. Compiled programs are stored in the binary cache.
+*
+* @return the linked program
+*******************************************************************/
+GLuint FinishShaderProgram(PendingProgram *pending)
+{
+    GLuint ShaderProgram = pending->program;
+    if (pending->shaders[0] == 0)
+    {
+        /* a program from the binary cache starts with all samplers on unit 0 as well */
+        SetSamplerUnits(ShaderProgram);
+        return ShaderProgram;
+    }
 
     GLint Success = 0;
     GLchar ErrorLog[1024];
 
-    /* Link shader code into executable shader program */
-    glLinkProgram(ShaderProgram);
-
-    /* Check results of linking step */
+    /* Check results of linking step; a failed link usually means a shader did not compile */
     glGetProgramiv(ShaderProgram, GL_LINK_STATUS, &Success);
 
     if (Success == 0)
     {
+        for (GLuint shader : pending->shaders)
+        {
+            GLint type = 0;
+            glGetShaderiv(shader, GL_COMPILE_STATUS, &Success);
+            glGetShaderiv(shader, GL_SHADER_TYPE, &type);
+            if (!Success)
+            {
+                glGetShaderInfoLog(shader, sizeof(ErrorLog), nullptr, ErrorLog);
+                fprintf(stderr, "Error compiling shader type %d: '%s'\n", type, ErrorLog);
+                exit(1);
+            }
+        }
+
         glGetProgramInfoLog(ShaderProgram, sizeof(ErrorLog), nullptr, ErrorLog);
         fprintf(stderr, "Error linking shader program: '%s'\n", ErrorLog);
         exit(1);
     }
 
+    /* Samplers of different types must not share a unit, and all of them start on unit 0 */
+    SetSamplerUnits(ShaderProgram);
+
     /* Check if shader program can be executed */
     glValidateProgram(ShaderProgram);
     glGetProgramiv(ShaderProgram, GL_VALIDATE_STATUS, &Success);
@@ -282,6 +374,15 @@ GLuint CreateShaderProgram(string vsPath, string fsPath)
         exit(1);
     }
 
+    /* The linked program keeps what it needs of the shaders */
+    for (GLuint shader : pending->shaders)
+    {
+        glDetachShader(ShaderProgram, shader);
+        glDeleteShader(shader);
+    }
+
+    ProgramCache::store(ShaderProgram, pending->key);
+    ProgramCache::countCompile((glfwGetTime() - pending->start) * 1000.0);
     return ShaderProgram;
 }
 
@@ -299,67 +400,3 @@ float constrainAngle(float x)
         x += 360;
     return x;
 }
-
-/* A value is saved in a buffer at the GPU */
-void BindUniform1f(const string& name, GLuint program, float val)
-{
-    GLint uniform = glGetUniformLocation(program, name.c_str());
-    glUniform1f(uniform, val);
-}
-
-void BindUniform4f(const string name, GLuint program, float* val)
-{
-    GLint uniform = glGetUniformLocation(program, name.c_str());
-    glUniformMatrix4fv(uniform, 1, GL_TRUE, val);
-}
-
-
-void BindUniform3f(const string name, GLuint program, Vector val)
-{
-    GLint uniform = glGetUniformLocation(program, name.c_str());
-    glUniform3f(uniform, val.x, val.y, val.z);
-}
-
-/*
- *  VBO vertex buffer object
- *  CBO color buffe object
- *  NBO normal buffer object
- *  IBO index buffer object
- *  UVBO uv buffer object
- */
-int BindBasics(GLuint VBO, GLuint CBO, GLuint IBO, GLuint NBO, GLuint UVBO)
-{
-    /* Bind buffer with vertex data of currently active object */
-    glEnableVertexAttribArray(vPosition);
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glVertexAttribPointer(vPosition, 3, GL_FLOAT, GL_FALSE, 0, 0);
-
-    /* Bind color buffer */
-    glEnableVertexAttribArray(vColor);
-    glBindBuffer(GL_ARRAY_BUFFER, CBO);
-    glVertexAttribPointer(vColor, 3, GL_FLOAT,GL_FALSE, 0, 0);
-
-    /* Bind normal buffer */
-    if (NBO != 0) {
-        glEnableVertexAttribArray(vNormal);
-        glBindBuffer(GL_ARRAY_BUFFER, NBO);
-        glVertexAttribPointer(vNormal, 3, GL_FLOAT,GL_FALSE, 0, 0);
-    }
-
-    /* Bind uv buffer */
-    if (UVBO != 0) {
-        glEnableVertexAttribArray(vUV);
-        glBindBuffer(GL_ARRAY_BUFFER, UVBO);
-        glVertexAttribPointer(vUV, 2, GL_FLOAT,GL_FALSE, 0, 0);
-    }
-
-    /* Bind index buffer */
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, IBO);
-
-    GLint size;
-    glGetBufferParameteriv(GL_ELEMENT_ARRAY_BUFFER, GL_BUFFER_SIZE, &size);
-
-    return size/sizeof(unsigned int);
-}
-
-
@@ -7,17 +7,24 @@
 #include <cmath>
 #include <cstring>
 #include <cstdio>
+#include <cstddef>
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
 #include "LoadShader.h"    /* Loading function for shader code */
+#include "MeshData.hpp"     /* Mesh streams from OBJ files or the binary mesh cache */
 #include "Vector.hpp"
+#include "uniformbuffer.hpp"
+#include "geometrypool.hpp"
 
 using namespace std;
 
-/* Indices to vertex attributes; in this case position only */
+/* Indices to vertex attributes; the rows of the per-instance model-view matrix take vInstance to
+ * vInstance + 2 and those of its normal matrix vInstanceNormal to vInstanceNormal + 2, followed by
+ * the instance's position decoding */
 enum DataID
 {
-    vPosition = 0, vColor = 1, vNormal = 2, vUV = 3
+    vPosition = 0, vColor = 1, vNormal = 2, vUV = 3, vInstance = 4, vInstanceNormal = 7, vInstanceScale = 10,
+    vInstanceBias = 11
 };
 
 typedef struct keyboard
@@ -49,22 +56,66 @@ typedef struct mouse
     float yAngle;
 } MouseState;
 
-void readMeshFile(string filename, float scale, GLuint *NBO, GLuint *VAO);
+/* Largest screen space error (in pixels) a level of detail may cause */
+#define MESH_LOD_PIXEL_ERROR 1.0f
 
-void SetupTexture(GLuint *TextureID, const char *filename);
+/* Index range of one level of detail in a mesh's index buffer */
+typedef struct
+{
+    GLsizei indexCount;
+    GLintptr indexOffset; // in bytes
+    float error;          // in mesh units, see MeshLod
+} MeshLevel;
 
-void AddShader(GLuint UsedShaderProgram, const char *ShaderCode, GLenum ShaderType);
+/* Location and draw parameters of a mesh in the geometry pool */
+typedef struct Mesh
+{
+    GLuint VAO;             // shared by all meshes of the arena
+    int arena;
+    GLint baseVertex;       // interleaved position, octahedral normal, uv
+    GLuint firstIndex;      // indices of all levels of detail
+    GLsizei vertexCount;
+    GLsizei indexCount;
+    GLenum indexType; // GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+    int lodCount;
+    MeshLevel lods[MESH_MAX_LODS];
+    float positionScale[3]; // decodes quantized positions in the vertex shader
+    float positionBias[3];
+    float center[3];        // bounding sphere in mesh space
+    float radius;
+    size_t gpuBytes;        // size of the vertex and index ranges
+    uint16_t sortId;        // small number that orders meshes in sort keys
+} Mesh;
 
-GLuint CreateShaderProgram(string vsPath, string fsPath);
+void readMeshFile(string filename, float scale, GeometryPool *pool, Mesh *mesh);
 
-float constrainAngle(float x);
+void SetupMeshParameters(const string &filename, const MeshView *view, Mesh *mesh);
 
-void BindUniform1f(const string& name, GLuint program, float val);
+void SetupMeshVertexArray(GLuint VAO, GLuint VBO, GLuint IBO, uint32_t vertexFormat, GLsizei stride);
 
-void BindUniform4f(const string name, GLuint program, float* matrix);
 
-void BindUniform3f(const string name, GLuint program, Vector matrix);
+int SelectMeshLod(const Mesh *mesh, const float *model, const float *view, const float *projection,
+                  float viewportHeight);
+
+void SetupTexture(GLuint *TextureID, const char *filename);
+
+void SetupTextureParameters();
 
-int BindBasics(GLuint VBO, GLuint CBO, GLuint IBO, GLuint NBO, GLuint UVBO);
+/* A program the driver may still be compiling and linking, see BeginShaderProgram */
+typedef struct
+{
+    GLuint program;
+    GLuint shaders[2];      // vertex and fragment shader, 0 if the program came from the binary cache
+    uint64_t key;           // of the program in the binary cache
+    double start;           // the compile time is counted from here
+} PendingProgram;
+
+GLuint AddShader(GLuint UsedShaderProgram, const char *ShaderCode, GLenum ShaderType);
+
+PendingProgram BeginShaderProgram(const string &vertexSource, const string &fragmentSource, const string &defines);
+
+GLuint FinishShaderProgram(PendingProgram *pending);
+
+float constrainAngle(float x);
 
 #endif
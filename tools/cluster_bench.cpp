@@ -0,0 +1,189 @@
+/******************************************************************
+*
+* cluster_bench.cpp
+*
+* Description: Times the binning of point lights into view space
+* clusters (see LightClustering) for 1 to 1024 lights scattered over
+* the workcell, with the scalar and the SSE light bounds and with one
+* and several threads. Sample points in the view frustum check that
+* every light reaching a point is listed in the point's cluster and
+* report how many lights a fragment would loop over.
+*
+* Usage: ./cluster_bench [--threads T] [--frames F] [--samples S]
+*
+*******************************************************************/
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "LightClustering.hpp"
+#include "Matrix.h"
+
+static float random_float(std::minstd_rand *random, float low, float high)
+{
+    return std::uniform_real_distribution<float>(low, high)(*random);
+}
+
+/* Returns the cluster of a view space position, as phong.fs computes it, or -1 outside the frustum */
+static int cluster_of(const ClusterGrid *grid, const float *projection, const float *position)
+{
+    float clip[4];
+    for (int r = 0; r < 4; r++)
+        clip[r] = projection[r * 4] * position[0] + projection[r * 4 + 1] * position[1] +
+                  projection[r * 4 + 2] * position[2] + projection[r * 4 + 3];
+    if (clip[3] <= 0 || fabsf(clip[0]) > clip[3] || fabsf(clip[1]) > clip[3] || fabsf(clip[2]) > clip[3])
+        return -1;
+
+    int x = (int) ((clip[0] / clip[3] * 0.5f + 0.5f) * LIGHT_CLUSTER_X);
+    int y = (int) ((clip[1] / clip[3] * 0.5f + 0.5f) * LIGHT_CLUSTER_Y);
+    int z = (int) (logf(fmaxf(-position[2], grid->nearPlane) / grid->nearPlane) * grid->sliceScale);
+    x = x < 0 ? 0 : (x >= LIGHT_CLUSTER_X ? LIGHT_CLUSTER_X - 1 : x);
+    y = y < 0 ? 0 : (y >= LIGHT_CLUSTER_Y ? LIGHT_CLUSTER_Y - 1 : y);
+    z = z < 0 ? 0 : (z >= LIGHT_CLUSTER_Z ? LIGHT_CLUSTER_Z - 1 : z);
+    return x + LIGHT_CLUSTER_X * (y + LIGHT_CLUSTER_Y * z);
+}
+
+template <typename F>
+static double time_ns(int frames, F function)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int f = 0; f < frames; f++)
+        function();
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / frames;
+}
+
+int main(int argc, char **argv)
+{
+    int threads = 0;
+    int frames = 200;
+    int sample_count = 100000;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            frames = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--samples") == 0 && i + 1 < argc)
+            sample_count = atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--threads T] [--frames F] [--samples S]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (frames < 1)
+        frames = 1;
+
+    /* camera as in main.cpp */
+    float projection[16], view[16], rotation[16];
+    SetPerspectiveMatrix(45.0f, 1000.0f / 800.0f, 0.1f, 100.0f, projection);
+    SetTranslation(0.0f, -5.0f, -20.0f, view);
+    SetRotationX(15.0f, rotation);
+    MultiplyMatrix(rotation, view, view);
+
+    LightClusterer serial(1);
+    LightClusterer parallel(threads);
+    printf("%d x %d x %d clusters, %d threads; times per frame, averaged over %d frames\n\n", LIGHT_CLUSTER_X,
+           LIGHT_CLUSTER_Y, LIGHT_CLUSTER_Z, parallel.getThreads(), frames);
+    printf("%6s %7s %10s %10s %10s %10s %8s %8s %9s %9s %6s\n", "lights", "visible", "bounds", "bounds",
+           "build", "build", "indices", "max per", "per frag", "per frag", "missed");
+    printf("%6s %7s %10s %10s %10s %10s %8s %8s %9s %9s %6s\n", "", "", "scalar us", "SSE us", "1 thr us",
+           "N thr us", "", "cluster", "clustered", "forward", "");
+
+    int agree = 1;
+    std::minstd_rand random(1);
+    for (int count = 1; count <= 1024; count *= 2)
+    {
+        /* indicator and work lights over a 30 x 30 workcell */
+        std::vector<PointLight> lights(count);
+        for (PointLight &light : lights)
+        {
+            light.position[0] = random_float(&random, -15.0f, 15.0f);
+            light.position[1] = random_float(&random, 0.0f, 4.0f);
+            light.position[2] = random_float(&random, -15.0f, 15.0f);
+            light.radius = random_float(&random, 1.0f, 4.0f);
+            for (float &c : light.color)
+                c = random_float(&random, 0.2f, 1.0f);
+            light.intensity = 1.0f;
+        }
+
+        ClusterGrid grid;
+        SetupClusterGrid(view, projection, &grid);
+        std::vector<ClusterLight> visible[2] = {std::vector<ClusterLight>(count), std::vector<ClusterLight>(count)};
+        std::vector<ClusterBounds> bounds[2] = {std::vector<ClusterBounds>(count), std::vector<ClusterBounds>(count)};
+        size_t kept[2];
+        double bound_time[2];
+        bound_time[0] = time_ns(frames, [&] {
+            kept[0] = BoundLightsScalar(lights.data(), count, &grid, visible[0].data(), bounds[0].data());
+        });
+        bound_time[1] = time_ns(frames, [&] {
+            kept[1] = BoundLights(lights.data(), count, &grid, visible[1].data(), bounds[1].data());
+        });
+        agree = agree && kept[0] == kept[1] &&
+                memcmp(visible[0].data(), visible[1].data(), kept[0] * sizeof(ClusterLight)) == 0 &&
+                memcmp(bounds[0].data(), bounds[1].data(), kept[0] * sizeof(ClusterBounds)) == 0;
+
+        LightClusters clusters[2];
+        double build_time[2];
+        build_time[0] = time_ns(frames, [&] {
+            serial.build(lights.data(), count, view, projection, &clusters[0]);
+        });
+        build_time[1] = time_ns(frames, [&] {
+            parallel.build(lights.data(), count, view, projection, &clusters[1]);
+        });
+        agree = agree && clusters[0].indices == clusters[1].indices &&
+                memcmp(clusters[0].ranges.data(), clusters[1].ranges.data(),
+                       LIGHT_CLUSTER_COUNT * sizeof(ClusterRange)) == 0;
+
+        const LightClusters &result = clusters[1];
+        uint32_t most = 0;
+        for (const ClusterRange &range : result.ranges)
+            most = range.count > most ? range.count : most;
+
+        /* points in the frustum, up to 30 units deep: each light reaching one must be in its cluster */
+        long looped = 0;
+        int samples = 0;
+        int missed = 0;
+        for (int s = 0; s < sample_count; s++)
+        {
+            float depth = random_float(&random, 1.0f, 30.0f);
+            float position[3] = {random_float(&random, -1.0f, 1.0f) * depth / projection[0],
+                                 random_float(&random, -1.0f, 1.0f) * depth / projection[5], -depth};
+            int cluster = cluster_of(&grid, projection, position);
+            if (cluster < 0)
+                continue;
+
+            const ClusterRange &range = result.ranges[cluster];
+            looped += range.count;
+            samples++;
+            for (size_t l = 0; l < result.lights.size(); l++)
+            {
+                const ClusterLight &light = result.lights[l];
+                float dx = light.position[0] - position[0];
+                float dy = light.position[1] - position[1];
+                float dz = light.position[2] - position[2];
+                if (dx * dx + dy * dy + dz * dz >= light.radius * light.radius)
+                    continue;
+
+                int listed = 0;
+                for (uint32_t i = range.offset; i < range.offset + range.count && !listed; i++)
+                    listed = result.indices[i] == l;
+                missed += !listed;
+            }
+        }
+
+        printf("%6d %7zu %10.2f %10.2f %10.2f %10.2f %8zu %8u %9.2f %9zu %6d\n", count, result.lights.size(),
+               bound_time[0] / 1000.0, bound_time[1] / 1000.0, build_time[0] / 1000.0, build_time[1] / 1000.0,
+               result.indices.size(), most, samples > 0 ? (double) looped / samples : 0.0, result.lights.size(),
+               missed);
+    }
+
+    printf("\nScalar and SSE bounds, one and %d threads agree: %s\n", parallel.getThreads(), agree ? "yes" : "NO");
+    return agree ? 0 : 1;
+}
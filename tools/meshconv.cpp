@@ -0,0 +1,78 @@
+/******************************************************************
+*
+* meshconv.cpp
+*
+* Description: Converts an OBJ file into the binary mesh cache
+* format (.meshbin) that readMeshFile maps at start-up.
+*
+* Usage: ./meshconv [--weld epsilon] [--raw] [--float] [--nolod] file.obj scale [out.meshbin]
+*        Without an output path the file is written where
+*        readMeshFile looks for it (cache/<name>-<scale>.meshbin).
+*
+*******************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "MeshData.hpp"
+
+int main(int argc, char **argv)
+{
+    MeshImportOptions options = DefaultMeshImportOptions;
+    int arg = 1;
+
+    for (;;)
+    {
+        if (arg + 1 < argc && strcmp(argv[arg], "--weld") == 0)
+        {
+            options.weldEpsilon = atof(argv[arg + 1]);
+            arg += 2;
+        } else if (arg < argc && strcmp(argv[arg], "--raw") == 0)
+        {
+            options.optimize = 0;
+            arg++;
+        } else if (arg < argc && strcmp(argv[arg], "--float") == 0)
+        {
+            options.quantize = 0;
+            arg++;
+        } else if (arg < argc && strcmp(argv[arg], "--nolod") == 0)
+        {
+            options.simplify = 0;
+            arg++;
+        } else
+            break;
+    }
+
+    if (argc - arg < 2)
+    {
+        fprintf(stderr, "Usage: %s [--weld epsilon] [--raw] [--float] [--nolod] file.obj scale [out.meshbin]\n", argv[0]);
+        return 1;
+    }
+
+    const char *objPath = argv[arg];
+    float scale = atof(argv[arg + 1]);
+    std::string outPath = argc - arg > 2 ? argv[arg + 2] : MeshCachePath(objPath, scale, &options);
+
+    if (!ConvertObjToMeshBin(objPath, scale, &options, outPath.c_str()))
+    {
+        fprintf(stderr, "Could not convert %s\n", objPath);
+        return 1;
+    }
+
+    MeshView view;
+    MeshBinHeader header;
+    if (!OpenMeshBin(outPath.c_str(), &view, &header))
+    {
+        fprintf(stderr, "Could not read back %s\n", outPath.c_str());
+        return 1;
+    }
+
+    printf("%s: %u vertices (%u bytes each), %u indices, %zu bytes\n", outPath.c_str(), view.vertexCount,
+           view.vertexStride, view.indexCount, view.file.size);
+    for (uint32_t l = 0; l < view.lodCount; l++)
+        printf("  level %u: %u triangles, error %g\n", l, view.lods[l].indexCount / 3, view.lods[l].error);
+    CloseMeshView(&view);
+
+    return 0;
+}
@@ -0,0 +1,88 @@
+/******************************************************************
+*
+* meshopt_report.cpp
+*
+* Description: Reports the post-transform vertex cache efficiency
+* (ACMR and ATVR) of meshes as exported and after the MeshOptimizer
+* pass that readMeshFile applies at load time.
+*
+* Usage: ./meshopt_report [--weld epsilon] [file.obj]...
+*        Without files the shipped models are used (run from the
+*        build folder like the main program).
+*
+*******************************************************************/
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "MeshData.hpp"
+#include "MeshOptimizer.hpp"
+
+static const int cache_sizes[] = {MESH_OPTIMIZER_CACHE_SIZE, 32};
+static const int cache_size_count = sizeof(cache_sizes) / sizeof(cache_sizes[0]);
+
+static VertexCacheStats analyze(const MeshData *mesh, int cache_size)
+{
+    return AnalyzeVertexCache(mesh->indices.data(), mesh->indices.size(), mesh->positions.size() / 3, cache_size);
+}
+
+int main(int argc, char **argv)
+{
+    MeshImportOptions options = DefaultMeshImportOptions;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--weld") == 0 && i + 1 < argc)
+            options.weldEpsilon = atof(argv[++i]);
+        else
+            files.push_back(argv[i]);
+    }
+
+    if (files.empty())
+        files = {"../models/base.obj", "../models/banana.obj", "../models/segment.obj", "../models/segment-2.obj"};
+
+    /* the triangle order as exported is what an unoptimized build uploads;
+     * only the full level of detail is compared */
+    options.optimize = 0;
+    options.simplify = 0;
+
+    printf("%-24s %9s %9s", "file", "vertices", "triangles");
+    for (int c = 0; c < cache_size_count; c++)
+        printf("   ACMR/%-2d before  after", cache_sizes[c]);
+    printf("   ATVR before  after %9s\n", "time");
+
+    for (const std::string &filename : files)
+    {
+        obj_scene_data data;
+        if (!parse_obj_scene(&data, filename.c_str()))
+        {
+            fprintf(stderr, "Could not parse %s\n", filename.c_str());
+            return 1;
+        }
+
+        MeshData raw;
+        BuildMeshData(&data, 1.0f, &options, &raw);
+        delete_obj_data(&data);
+
+        MeshData optimized = raw;
+        auto start = std::chrono::steady_clock::now();
+        OptimizeMeshData(&optimized);
+        auto stop = std::chrono::steady_clock::now();
+
+        const char *name = strrchr(filename.c_str(), '/');
+        printf("%-24s %9zu %9zu", name ? name + 1 : filename.c_str(), raw.positions.size() / 3,
+               raw.indices.size() / 3);
+        for (int c = 0; c < cache_size_count; c++)
+            printf("   %14.3f %6.3f", analyze(&raw, cache_sizes[c]).acmr, analyze(&optimized, cache_sizes[c]).acmr);
+        printf("   %11.3f %6.3f %7.1fms\n", analyze(&raw, MESH_OPTIMIZER_CACHE_SIZE).atvr,
+               analyze(&optimized, MESH_OPTIMIZER_CACHE_SIZE).atvr,
+               std::chrono::duration<double, std::milli>(stop - start).count());
+    }
+
+    return 0;
+}
@@ -0,0 +1,180 @@
+/******************************************************************
+*
+* obj_bench.cpp
+*
+* Description: Compares the OBJ parser paths on the shipped models
+* and on large synthetic meshes, and checks that every path yields
+* the same obj_scene_data.
+*
+* Usage: ./obj_bench [--threads T] [--synthetic N]... [file.obj]...
+*        Without arguments the shipped models and two synthetic grids
+*        are used (run from the build folder like the main program).
+*
+*******************************************************************/
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "OBJParser.hpp"
+
+static const char *mode_names[] = {"stdio", "mapped", "parallel"};
+static const int mode_count = sizeof(mode_names) / sizeof(mode_names[0]);
+
+/* Writes a triangulated (n+1)x(n+1) grid with normals and uvs */
+static std::string write_synthetic_obj(int n)
+{
+    char filename[64];
+    snprintf(filename, sizeof(filename), "synthetic_%d.obj", n);
+
+    FILE *out = fopen(filename, "w");
+    if (out == nullptr)
+    {
+        fprintf(stderr, "Could not write %s\n", filename);
+        exit(1);
+    }
+
+    fprintf(out, "# synthetic grid %d x %d\no grid\n", n, n);
+    for (int y = 0; y <= n; y++)
+        for (int x = 0; x <= n; x++)
+            fprintf(out, "v %f %f %f\n", x / (float) n, 0.05f * sinf(x * 0.3f) * cosf(y * 0.2f), y / (float) n);
+    for (int y = 0; y <= n; y++)
+        for (int x = 0; x <= n; x++)
+            fprintf(out, "vt %f %f\n", x / (float) n, y / (float) n);
+    fprintf(out, "vn 0.000000 1.000000 0.000000\ns 1\n");
+
+    for (int y = 0; y < n; y++)
+    {
+        for (int x = 0; x < n; x++)
+        {
+            int a = y * (n + 1) + x + 1;
+            int b = a + 1;
+            int c = a + n + 1;
+            int d = c + 1;
+            fprintf(out, "f %d/%d/1 %d/%d/1 %d/%d/1\n", a, a, c, c, b, b);
+            /* relative indices for the second half of every quad */
+            fprintf(out, "f %d/%d/-1 %d/%d/-1 %d/%d/-1\n",
+                    b - (n + 1) * (n + 1) - 1, b - (n + 1) * (n + 1) - 1,
+                    c - (n + 1) * (n + 1) - 1, c - (n + 1) * (n + 1) - 1,
+                    d - (n + 1) * (n + 1) - 1, d - (n + 1) * (n + 1) - 1);
+        }
+    }
+
+    fclose(out);
+    return filename;
+}
+
+template<typename T>
+static int same_array(const T *a, const T *b, int count)
+{
+    return count == 0 || memcmp(a, b, count * sizeof(T)) == 0;
+}
+
+static int same_scene(const obj_scene_data *a, const obj_scene_data *b)
+{
+    if (a->vertex_count != b->vertex_count || a->vertex_normal_count != b->vertex_normal_count ||
+        a->vertex_texture_count != b->vertex_texture_count || a->face_count != b->face_count ||
+        a->material_count != b->material_count)
+        return 0;
+
+    int indices = a->face_count * MAX_VERTEX_COUNT;
+    return same_array(a->vertex_positions, b->vertex_positions, a->vertex_count * 3) &&
+           same_array(a->vertex_normals, b->vertex_normals, a->vertex_normal_count * 3) &&
+           same_array(a->vertex_uvs, b->vertex_uvs, a->vertex_texture_count * 2) &&
+           same_array(a->face_vertex_index, b->face_vertex_index, indices) &&
+           same_array(a->face_normal_index, b->face_normal_index, indices) &&
+           same_array(a->face_texture_index, b->face_texture_index, indices) &&
+           same_array(a->face_vertex_count, b->face_vertex_count, a->face_count) &&
+           same_array(a->face_material_index, b->face_material_index, a->face_count);
+}
+
+/* Returns the best of 'runs' parse times in milliseconds */
+static double time_parse(const std::string &filename, obj_parse_mode mode, int threads, int runs,
+                         obj_scene_data *result)
+{
+    double best = 1e30;
+
+    for (int run = 0; run < runs; run++)
+    {
+        obj_scene_data data;
+        auto start = std::chrono::steady_clock::now();
+        if (!parse_obj_scene_mode(&data, filename.c_str(), mode, threads))
+        {
+            fprintf(stderr, "Could not parse %s\n", filename.c_str());
+            exit(1);
+        }
+        auto stop = std::chrono::steady_clock::now();
+
+        double ms = std::chrono::duration<double, std::milli>(stop - start).count();
+        if (ms < best)
+            best = ms;
+
+        if (run == runs - 1)
+            *result = data;
+        else
+            delete_obj_data(&data);
+    }
+
+    return best;
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<std::string> files;
+    std::vector<int> synthetic;
+    int threads = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--synthetic") == 0 && i + 1 < argc)
+            synthetic.push_back(atoi(argv[++i]));
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else
+            files.push_back(argv[i]);
+    }
+
+    if (files.empty() && synthetic.empty())
+    {
+        files = {"../models/base.obj", "../models/banana.obj", "../models/segment.obj", "../models/segment-2.obj"};
+        synthetic = {300, 1000};
+    }
+
+    for (int n : synthetic)
+        files.push_back(write_synthetic_obj(n));
+
+    printf("%-28s %10s", "file", "faces");
+    for (int m = 0; m < mode_count; m++)
+        printf(" %10s", mode_names[m]);
+    printf(" %8s %s\n", "speedup", "identical");
+
+    int all_identical = 1;
+    for (const std::string &filename : files)
+    {
+        obj_scene_data results[mode_count];
+        double times[mode_count];
+
+        for (int m = 0; m < mode_count; m++)
+            times[m] = time_parse(filename, (obj_parse_mode) m, threads, 3, &results[m]);
+
+        int identical = 1;
+        for (int m = 1; m < mode_count; m++)
+            identical &= same_scene(&results[0], &results[m]);
+        all_identical &= identical;
+
+        const char *name = strrchr(filename.c_str(), '/');
+        printf("%-28s %10d", name ? name + 1 : filename.c_str(), results[0].face_count);
+        for (int m = 0; m < mode_count; m++)
+            printf(" %8.2fms", times[m]);
+        printf(" %7.2fx %s\n", times[OBJ_PARSE_STDIO] / times[OBJ_PARSE_PARALLEL], identical ? "yes" : "NO");
+
+        for (int m = 0; m < mode_count; m++)
+            delete_obj_data(&results[m]);
+    }
+
+    return all_identical ? 0 : 1;
+}
@@ -0,0 +1,291 @@
+/******************************************************************
+*
+* vs_bench.cpp
+*
+* Description: Compares the per-vertex work of phong.vs before and
+* after the model-view and normal matrices moved to the CPU. Both
+* vertex shaders are written out in C++ over a scalar type; with a
+* counting type they report the ALU operations per vertex, with
+* float they are timed over a synthetic batch of instances.
+*
+* Usage: ./vs_bench [--instances N] [--vertices V]
+*
+*******************************************************************/
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#include "Matrix.h"
+
+/* Operations of the last evaluated shaders */
+static long op_add, op_mul, op_div, op_sqrt, op_other;
+
+/* Float that counts the operations applied to it */
+struct Counted
+{
+    float v;
+
+    Counted(float value = 0.0f) : v(value)
+    {}
+};
+
+static Counted operator+(Counted a, Counted b) { op_add++; return a.v + b.v; }
+static Counted operator-(Counted a, Counted b) { op_add++; return a.v - b.v; }
+static Counted operator-(Counted a) { op_add++; return -a.v; }
+static Counted operator*(Counted a, Counted b) { op_mul++; return a.v * b.v; }
+static Counted operator/(Counted a, Counted b) { op_div++; return a.v / b.v; }
+static Counted sqrt_op(Counted a) { op_sqrt++; return sqrtf(a.v); }
+static Counted abs_op(Counted a) { op_other++; return fabsf(a.v); }
+static Counted max_op(Counted a, Counted b) { op_other++; return a.v > b.v ? a.v : b.v; }
+static Counted select_positive(Counted a, Counted if_positive, Counted otherwise)
+{
+    op_other++;
+    return a.v >= 0 ? if_positive : otherwise;
+}
+
+static float sqrt_op(float a) { return sqrtf(a); }
+static float abs_op(float a) { return fabsf(a); }
+static float max_op(float a, float b) { return a > b ? a : b; }
+static float select_positive(float a, float if_positive, float otherwise) { return a >= 0 ? if_positive : otherwise; }
+
+/* Inputs of one vertex shader invocation; matrices are row-major */
+typedef struct
+{
+    float view[16];
+    float projection[16];
+    float model[16];            // old shader: the instance's model matrix
+    float modelView[16];        // new shader: rows 0 to 2 of view * model
+    float normal[9];            // new shader: SetNormalMatrix(modelView)
+    float position[3];
+    float encoded[2];           // octahedral normal
+} VertexInput;
+
+template <typename T>
+static void mat4_mul(const T *a, const T *b, T *result)
+{
+    for (int r = 0; r < 4; r++)
+        for (int c = 0; c < 4; c++)
+            result[r * 4 + c] = a[r * 4] * b[c] + a[r * 4 + 1] * b[4 + c] + a[r * 4 + 2] * b[8 + c] +
+                                a[r * 4 + 3] * b[12 + c];
+}
+
+template <typename T>
+static void mat4_vec(const T *m, const T *v, T *result)
+{
+    for (int r = 0; r < 4; r++)
+        result[r] = m[r * 4] * v[0] + m[r * 4 + 1] * v[1] + m[r * 4 + 2] * v[2] + m[r * 4 + 3] * v[3];
+}
+
+/* GLSL inverse(mat4) as drivers commonly lower it: 2x2 sub-determinants, cofactors, 1 / determinant */
+template <typename T>
+static void mat4_inverse(const T *m, T *result)
+{
+    T s0 = m[0] * m[5] - m[4] * m[1], s1 = m[0] * m[6] - m[4] * m[2], s2 = m[0] * m[7] - m[4] * m[3];
+    T s3 = m[1] * m[6] - m[5] * m[2], s4 = m[1] * m[7] - m[5] * m[3], s5 = m[2] * m[7] - m[6] * m[3];
+    T c5 = m[10] * m[15] - m[14] * m[11], c4 = m[9] * m[15] - m[13] * m[11], c3 = m[9] * m[14] - m[13] * m[10];
+    T c2 = m[8] * m[15] - m[12] * m[11], c1 = m[8] * m[14] - m[12] * m[10], c0 = m[8] * m[13] - m[12] * m[9];
+
+    T inverse_det = T(1.0f) / (s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0);
+
+    result[0] = (m[5] * c5 - m[6] * c4 + m[7] * c3) * inverse_det;
+    result[1] = (-m[1] * c5 + m[2] * c4 - m[3] * c3) * inverse_det;
+    result[2] = (m[13] * s5 - m[14] * s4 + m[15] * s3) * inverse_det;
+    result[3] = (-m[9] * s5 + m[10] * s4 - m[11] * s3) * inverse_det;
+    result[4] = (-m[4] * c5 + m[6] * c2 - m[7] * c1) * inverse_det;
+    result[5] = (m[0] * c5 - m[2] * c2 + m[3] * c1) * inverse_det;
+    result[6] = (-m[12] * s5 + m[14] * s2 - m[15] * s1) * inverse_det;
+    result[7] = (m[8] * s5 - m[10] * s2 + m[11] * s1) * inverse_det;
+    result[8] = (m[4] * c4 - m[5] * c2 + m[7] * c0) * inverse_det;
+    result[9] = (-m[0] * c4 + m[1] * c2 - m[3] * c0) * inverse_det;
+    result[10] = (m[12] * s4 - m[13] * s2 + m[15] * s0) * inverse_det;
+    result[11] = (-m[8] * s4 + m[9] * s2 - m[11] * s0) * inverse_det;
+    result[12] = (-m[4] * c3 + m[5] * c1 - m[6] * c0) * inverse_det;
+    result[13] = (m[0] * c3 - m[1] * c1 + m[2] * c0) * inverse_det;
+    result[14] = (-m[12] * s3 + m[13] * s1 - m[14] * s0) * inverse_det;
+    result[15] = (m[8] * s3 - m[9] * s1 + m[10] * s0) * inverse_det;
+}
+
+template <typename T>
+static void normalize3(T *v)
+{
+    T inverse_length = T(1.0f) / sqrt_op(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    for (int k = 0; k < 3; k++)
+        v[k] = v[k] * inverse_length;
+}
+
+/* decodeNormal() of phong.vs */
+template <typename T>
+static void decode_normal(const T *e, T *n)
+{
+    n[0] = e[0];
+    n[1] = e[1];
+    n[2] = T(1.0f) - abs_op(e[0]) - abs_op(e[1]);
+    T t = max_op(-n[2], T(0.0f));
+    n[0] = n[0] + select_positive(n[0], -t, t);
+    n[1] = n[1] + select_positive(n[1], -t, t);
+    normalize3(n);
+}
+
+/* phong.vs with transpose(inverse(ViewMatrix * TransformMatrix)) per vertex */
+template <typename T>
+static void shade_inverse(const VertexInput &in, T *clip, T *normal)
+{
+    T view[16], projection[16], model[16];
+    for (int i = 0; i < 16; i++)
+    {
+        view[i] = in.view[i];
+        projection[i] = in.projection[i];
+        model[i] = in.model[i];
+    }
+
+    T model_view[16], model_view_projection[16], inverse[16];
+    mat4_mul(view, model, model_view);
+    mat4_mul(projection, model_view, model_view_projection);
+    mat4_inverse(model_view, inverse);
+
+    T position[4] = {in.position[0], in.position[1], in.position[2], 1.0f};
+    T eye[4];
+    mat4_vec(model_view, position, eye);
+
+    /* normal matrix = transpose(inverse), applied to vec4(n, 1) */
+    T encoded[2] = {in.encoded[0], in.encoded[1]};
+    T n[4];
+    decode_normal(encoded, n);
+    n[3] = 1.0f;
+    for (int r = 0; r < 3; r++)
+        normal[r] = inverse[r] * n[0] + inverse[4 + r] * n[1] + inverse[8 + r] * n[2] + inverse[12 + r] * n[3];
+    normalize3(normal);
+
+    mat4_vec(model_view_projection, position, clip);
+}
+
+/* phong.vs with the model-view and normal matrix as instance attributes */
+template <typename T>
+static void shade_instanced(const VertexInput &in, T *clip, T *normal)
+{
+    T position[4] = {in.position[0], in.position[1], in.position[2], 1.0f};
+    T eye[4];
+    for (int r = 0; r < 3; r++)
+        eye[r] = T(in.modelView[r * 4]) * position[0] + T(in.modelView[r * 4 + 1]) * position[1] +
+                 T(in.modelView[r * 4 + 2]) * position[2] + T(in.modelView[r * 4 + 3]);
+    eye[3] = 1.0f;
+
+    T encoded[2] = {in.encoded[0], in.encoded[1]};
+    T n[3];
+    decode_normal(encoded, n);
+    for (int r = 0; r < 3; r++)
+        normal[r] = T(in.normal[r * 3]) * n[0] + T(in.normal[r * 3 + 1]) * n[1] + T(in.normal[r * 3 + 2]) * n[2];
+    normalize3(normal);
+
+    T projection[16];
+    for (int i = 0; i < 16; i++)
+        projection[i] = in.projection[i];
+    mat4_vec(projection, eye, clip);
+}
+
+static float random_float(std::minstd_rand *random, float range)
+{
+    return std::uniform_real_distribution<float>(-range, range)(*random);
+}
+
+int main(int argc, char **argv)
+{
+    int instance_count = 1000;
+    int vertex_count = 2000;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--instances") == 0 && i + 1 < argc)
+            instance_count = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--vertices") == 0 && i + 1 < argc)
+            vertex_count = atoi(argv[++i]);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--instances N] [--vertices V]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    /* camera as in main.cpp, arms on a grid with random, non-uniformly scaled parts */
+    VertexInput base;
+    SetPerspectiveMatrix(45.0f, 1000.0f / 800.0f, 0.1f, 100.0f, base.projection);
+    SetTranslation(0.0f, -5.0f, -20.0f, base.view);
+
+    std::minstd_rand random(1);
+    std::vector<VertexInput> instances(instance_count, base);
+    double cpu_time = 0;
+    for (VertexInput &instance : instances)
+    {
+        float rotation[16], scale[16];
+        SetRotationY(random_float(&random, 180.0f), rotation);
+        SetScaleMatrix(0.3f, 0.3f + random_float(&random, 0.1f), 0.3f, scale);
+        SetTranslation(random_float(&random, 20.0f), 0.0f, random_float(&random, 20.0f), instance.model);
+        MultiplyMatrix(instance.model, rotation, instance.model);
+        MultiplyMatrix(instance.model, scale, instance.model);
+
+        /* what RenderQueue::push does once per instance */
+        auto start = std::chrono::steady_clock::now();
+        MultiplyMatrix(instance.view, instance.model, instance.modelView);
+        SetNormalMatrix(instance.modelView, instance.normal);
+        cpu_time += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    std::vector<float> positions(vertex_count * 3), encoded(vertex_count * 2);
+    for (float &p : positions)
+        p = random_float(&random, 1.0f);
+    for (float &e : encoded)
+        e = random_float(&random, 0.5f);
+
+    printf("%-32s %6s %6s %6s %6s %6s %7s %12s\n", "vertex shader", "add", "mul", "div", "sqrt", "other",
+           "total", "ns/vertex");
+
+    const char *names[] = {"transpose(inverse()) per vertex", "CPU model-view/normal matrix"};
+    double checksum[2] = {0, 0};
+    for (int variant = 0; variant < 2; variant++)
+    {
+        VertexInput &in = instances[0];
+        memcpy(in.position, &positions[0], sizeof(in.position));
+        memcpy(in.encoded, &encoded[0], sizeof(in.encoded));
+
+        Counted clip[4], normal[3];
+        op_add = op_mul = op_div = op_sqrt = op_other = 0;
+        if (variant == 0)
+            shade_inverse(in, clip, normal);
+        else
+            shade_instanced(in, clip, normal);
+        long total = op_add + op_mul + op_div + op_sqrt + op_other;
+
+        auto start = std::chrono::steady_clock::now();
+        for (VertexInput &instance : instances)
+        {
+            for (int v = 0; v < vertex_count; v++)
+            {
+                memcpy(instance.position, &positions[v * 3], sizeof(instance.position));
+                memcpy(instance.encoded, &encoded[v * 2], sizeof(instance.encoded));
+
+                float clip_float[4], normal_float[3];
+                if (variant == 0)
+                    shade_inverse(instance, clip_float, normal_float);
+                else
+                    shade_instanced(instance, clip_float, normal_float);
+                checksum[variant] += clip_float[0] / clip_float[3] + normal_float[1];
+            }
+        }
+        double time = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        printf("%-32s %6ld %6ld %6ld %6ld %6ld %7ld %12.2f\n", names[variant], op_add, op_mul, op_div, op_sqrt,
+               op_other, total, time / ((double) instance_count * vertex_count));
+    }
+
+    printf("\nCPU cost of the instanced path: %.1f ns per instance (view * model and SetNormalMatrix)\n",
+           cpu_time / instance_count);
+    printf("Results agree: %s (checksums %.6g and %.6g)\n",
+           fabs(checksum[0] - checksum[1]) <= 1e-3 * fabs(checksum[0]) + 1e-3 ? "yes" : "NO", checksum[0],
+           checksum[1]);
+    return 0;
+}